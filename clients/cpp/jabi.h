@@ -3,5 +3,7 @@
 
 #include "libjabi/interfaces/uart.h"
 #include "libjabi/interfaces/usb.h"
+#include "libjabi/can/receiver.h"
+#include "libjabi/can/dbc.h"
 
 #endif // JABI_H
@@ -0,0 +1,350 @@
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <libjabi/byteorder.h>
+#include "dbc.h"
+
+namespace jabi {
+
+// payload rows padded so a signal ending in the last byte can still load 8
+static constexpr size_t ROW_LEN = CAN_MAX_LEN + 8;
+static constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+static constexpr uint32_t DBC_EXT_FLAG = 0x80000000;
+static constexpr uint32_t DBC_INDEPENDENT_ID = 0xC0000000; // VECTOR__INDEPENDENT_SIG_MSG
+
+DBC DBC::load(const std::string &path) {
+    std::ifstream f(path);
+    if (!f) {
+        throw std::runtime_error("failed to open " + path);
+    }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return parse(ss.str());
+}
+
+DBC DBC::parse(const std::string &text) {
+    static const std::regex bo_re(R"(^\s*BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+\w+)");
+    static const std::regex sg_re(
+        R"(^\s*SG_\s+(\w+)\s*(M|m\d+M?)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*)"
+        R"(\(\s*([^,\s]+)\s*,\s*([^)\s]+)\s*\)\s*\[\s*([^|\s]+)\s*\|\s*([^\]\s]+)\s*\]\s*"([^"]*)\")");
+    static const std::regex valtype_re(R"(^\s*SIG_VALTYPE_\s+(\d+)\s+(\w+)\s*:\s*([012])\s*;)");
+
+    DBC dbc;
+    std::istringstream in(text);
+    std::string line;
+    DBCMessage *cur = nullptr;
+    int lineno = 0;
+    std::smatch m;
+    while (std::getline(in, line)) {
+        lineno++;
+        if (std::regex_search(line, m, bo_re)) {
+            uint32_t raw_id = static_cast<uint32_t>(std::stoul(m[1]));
+            if (raw_id == DBC_INDEPENDENT_ID) {
+                cur = nullptr; // placeholder for unassigned signals, never on the bus
+                continue;
+            }
+            dbc.msgs.push_back(DBCMessage{
+                .id      = static_cast<int>(raw_id & 0x1FFFFFFF),
+                .ext     = (raw_id & DBC_EXT_FLAG) != 0,
+                .name    = m[2],
+                .dlc     = std::stoi(m[3]),
+                .signals = {},
+            });
+            cur = &dbc.msgs.back();
+        } else if (std::regex_search(line, m, sg_re)) {
+            if (!cur) {
+                continue;
+            }
+            std::string mux = m[2];
+            DBCSignal sig = {
+                .name          = m[1],
+                .start         = std::stoi(m[3]),
+                .len           = std::stoi(m[4]),
+                .little_endian = m[5] == "1",
+                .is_signed     = m[6] == "-",
+                .factor        = std::stod(m[7]),
+                .offset        = std::stod(m[8]),
+                .min           = std::stod(m[9]),
+                .max           = std::stod(m[10]),
+                .unit          = m[11],
+                .is_mux        = !mux.empty() && mux.back() == 'M',
+                .mux           = !mux.empty() && mux[0] == 'm' ? std::stoi(mux.substr(1)) : -1,
+                .type          = DBCValueType::INTEGER,
+            };
+            if (sig.len < 1 || sig.len > 64 || sig.start < 0 ||
+                    sig.start >= static_cast<int>(8 * CAN_MAX_LEN)) {
+                throw std::runtime_error("bad signal layout on line " + std::to_string(lineno));
+            }
+            cur->signals.push_back(sig);
+        } else if (std::regex_search(line, m, valtype_re)) {
+            uint32_t raw_id = static_cast<uint32_t>(std::stoul(m[1]));
+            for (auto &msg : dbc.msgs) {
+                if (msg.id != static_cast<int>(raw_id & 0x1FFFFFFF) ||
+                        msg.ext != ((raw_id & DBC_EXT_FLAG) != 0)) {
+                    continue;
+                }
+                for (auto &sig : msg.signals) {
+                    if (sig.name == m[2].str()) {
+                        sig.type = static_cast<DBCValueType>(std::stoi(m[3]));
+                    }
+                }
+            }
+        } else if (line.find("BO_ ") != std::string::npos && line.find("BO_TX_BU_") == std::string::npos) {
+            cur = nullptr; // malformed message, don't hang its signals off the previous one
+        }
+    }
+
+    for (size_t i = 0; i < dbc.msgs.size(); i++) {
+        auto &msg = dbc.msgs[i];
+        std::vector<plan_t> plan;
+        int mux_signal = -1;
+        for (size_t s = 0; s < msg.signals.size(); s++) {
+            plan.push_back(compile(msg.signals[s]));
+            if (msg.signals[s].is_mux && msg.signals[s].mux < 0) {
+                mux_signal = static_cast<int>(s);
+            }
+        }
+        dbc.plans.push_back(plan);
+        dbc.mux_signal.push_back(mux_signal);
+        dbc.index[key(msg.id, msg.ext)] = i;
+    }
+    return dbc;
+}
+
+DBC::plan_t DBC::compile(const DBCSignal &sig) {
+    plan_t p = {
+        .byte0         = 0,
+        .nbytes        = 0,
+        .shift         = 0,
+        .little_endian = sig.little_endian,
+        .is_signed     = sig.is_signed,
+        .len           = static_cast<uint8_t>(sig.len),
+        .mask          = sig.len == 64 ? ~0ULL : (1ULL << sig.len) - 1,
+        .factor        = sig.factor,
+        .offset        = sig.offset,
+        .mux           = sig.mux,
+        .type          = sig.type,
+    };
+    int first, last;
+    if (sig.little_endian) {
+        // start is the lsb, bits count up through the bytes
+        first = sig.start / 8;
+        last = (sig.start + sig.len - 1) / 8;
+        p.shift = sig.start % 8;
+    } else {
+        // start is the msb in sawtooth numbering, renumber msb first to walk forward
+        int msb = (sig.start / 8) * 8 + (7 - sig.start % 8);
+        int lsb = msb + sig.len - 1;
+        first = msb / 8;
+        last = lsb / 8;
+        int nbytes = last - first + 1;
+        p.shift = 7 - lsb % 8 + (nbytes <= 8 ? 8 * (8 - nbytes) : 0);
+    }
+    p.byte0 = static_cast<uint8_t>(first);
+    p.nbytes = static_cast<uint8_t>(last - first + 1);
+    return p;
+}
+
+enum class conv_t { UNSIGNED, SIGNED, FLOAT, DOUBLE };
+
+template <typename Plan>
+static conv_t conv_of(const Plan &p) {
+    switch (p.type) {
+        case DBCValueType::FLOAT:  return conv_t::FLOAT;
+        case DBCValueType::DOUBLE: return conv_t::DOUBLE;
+        default:                   return p.is_signed ? conv_t::SIGNED : conv_t::UNSIGNED;
+    }
+}
+
+// b is the plan's first byte, rows are padded so 9 bytes can always be read
+template <bool LE, typename Plan>
+static inline uint64_t load_bits(const Plan &p, const uint8_t *b) {
+    uint64_t v;
+    if constexpr (LE) {
+        std::memcpy(&v, b, sizeof(v));
+        v = letoh<uint64_t>(v) >> p.shift;
+        if (p.nbytes > 8) {
+            v |= static_cast<uint64_t>(b[8]) << (64 - p.shift); // 9 bytes implies shift > 0
+        }
+    } else {
+        v = 0;
+        for (int i = 0; i < 8; i++) {
+            v = (v << 8) | b[i];
+        }
+        if (p.nbytes > 8) {
+            v = (v << (8 - p.shift)) | (b[8] >> p.shift);
+        } else {
+            v >>= p.shift;
+        }
+    }
+    return v & p.mask;
+}
+
+template <conv_t C, typename Plan>
+static inline double convert(const Plan &p, uint64_t v) {
+    if constexpr (C == conv_t::FLOAT) {
+        float f;
+        uint32_t u = static_cast<uint32_t>(v);
+        std::memcpy(&f, &u, sizeof(f));
+        return f;
+    } else if constexpr (C == conv_t::DOUBLE) {
+        double d;
+        std::memcpy(&d, &v, sizeof(d));
+        return d;
+    } else if constexpr (C == conv_t::SIGNED) {
+        int sh = 64 - p.len; // sign extend from the top bit of the signal
+        return static_cast<double>(static_cast<int64_t>(v << sh) >> sh);
+    } else {
+        return static_cast<double>(v);
+    }
+}
+
+template <bool LE, conv_t C, typename Plan>
+static void column(const Plan &p, const uint8_t *rows, const size_t *lens, size_t n, double *out) {
+    size_t end = static_cast<size_t>(p.byte0) + p.nbytes;
+    for (size_t j = 0; j < n; j++) {
+        uint64_t v = load_bits<LE>(p, rows + j * ROW_LEN + p.byte0);
+        double val = convert<C>(p, v) * p.factor + p.offset;
+        out[j] = lens[j] < end ? NaN : val; // short rows are zero padded, safe to read
+    }
+}
+
+template <conv_t C, typename Plan>
+static void column(const Plan &p, const uint8_t *rows, const size_t *lens, size_t n, double *out) {
+    if (p.little_endian) {
+        column<true, C>(p, rows, lens, n, out);
+    } else {
+        column<false, C>(p, rows, lens, n, out);
+    }
+}
+
+double DBC::extract(const plan_t &p, const uint8_t *row, size_t len, uint64_t *raw) {
+    if (static_cast<size_t>(p.byte0) + p.nbytes > len) {
+        return NaN;
+    }
+
+    const uint8_t *b = row + p.byte0;
+    uint64_t v = p.little_endian ? load_bits<true>(p, b) : load_bits<false>(p, b);
+    if (raw) {
+        *raw = v;
+    }
+
+    double val;
+    switch (conv_of(p)) {
+        case conv_t::FLOAT:    val = convert<conv_t::FLOAT>(p, v);    break;
+        case conv_t::DOUBLE:   val = convert<conv_t::DOUBLE>(p, v);   break;
+        case conv_t::SIGNED:   val = convert<conv_t::SIGNED>(p, v);   break;
+        default:               val = convert<conv_t::UNSIGNED>(p, v); break;
+    }
+    return val * p.factor + p.offset;
+}
+
+void DBC::extract_column(const plan_t &p, const uint8_t *rows, const size_t *lens, size_t n,
+                         double *out) {
+    switch (conv_of(p)) {
+        case conv_t::FLOAT:    column<conv_t::FLOAT>(p, rows, lens, n, out);    break;
+        case conv_t::DOUBLE:   column<conv_t::DOUBLE>(p, rows, lens, n, out);   break;
+        case conv_t::SIGNED:   column<conv_t::SIGNED>(p, rows, lens, n, out);   break;
+        case conv_t::UNSIGNED: column<conv_t::UNSIGNED>(p, rows, lens, n, out); break;
+    }
+}
+
+const DBCMessage *DBC::find(int id, bool ext) const {
+    auto it = index.find(key(id, ext));
+    return it == index.end() ? nullptr : &msgs[it->second];
+}
+
+std::map<std::string, double> DBC::decode(const CANMessage &msg) const {
+    std::map<std::string, double> ret;
+    auto it = index.find(key(msg.id, msg.ext));
+    if (it == index.end() || msg.rtr) {
+        return ret;
+    }
+    size_t i = it->second;
+
+    uint8_t row[ROW_LEN] = {};
+    std::memcpy(row, msg.data.data(), msg.data.size());
+
+    uint64_t mux_raw = ~0ULL;
+    if (mux_signal[i] >= 0) {
+        extract(plans[i][mux_signal[i]], row, msg.data.size(), &mux_raw);
+    }
+    for (size_t s = 0; s < plans[i].size(); s++) {
+        auto &p = plans[i][s];
+        if (p.mux >= 0 && static_cast<uint64_t>(p.mux) != mux_raw) {
+            continue; // not in this frame
+        }
+        ret[msgs[i].signals[s].name] = extract(p, row, msg.data.size());
+    }
+    return ret;
+}
+
+std::vector<DBCColumns> DBC::decode(const std::vector<CANMessage> &frames) const {
+    std::vector<std::vector<const CANMessage*>> buckets(msgs.size());
+    for (auto &f : frames) {
+        auto it = index.find(key(f.id, f.ext));
+        if (it != index.end() && !f.rtr) {
+            buckets[it->second].push_back(&f);
+        }
+    }
+
+    std::vector<DBCColumns> ret;
+    std::vector<uint8_t> rows;
+    std::vector<size_t> lens;
+    std::vector<uint64_t> mux_raw;
+    for (size_t i = 0; i < msgs.size(); i++) {
+        auto &bucket = buckets[i];
+        size_t n = bucket.size();
+        if (!n) {
+            continue;
+        }
+
+        // pack the payloads so each column below is one pass over a flat array
+        rows.assign(n * ROW_LEN, 0);
+        lens.resize(n);
+        DBCColumns c = {
+            .id         = msgs[i].id,
+            .ext        = msgs[i].ext,
+            .name       = msgs[i].name,
+            .timestamps = std::vector<uint64_t>(n),
+            .signals    = {},
+            .values     = std::vector<std::vector<double>>(plans[i].size()),
+        };
+        for (size_t j = 0; j < n; j++) {
+            std::memcpy(&rows[j * ROW_LEN], bucket[j]->data.data(), bucket[j]->data.size());
+            lens[j] = bucket[j]->data.size();
+            c.timestamps[j] = bucket[j]->timestamp;
+        }
+
+        int ms = mux_signal[i];
+        if (ms >= 0) {
+            mux_raw.assign(n, ~0ULL);
+            for (size_t j = 0; j < n; j++) {
+                extract(plans[i][ms], &rows[j * ROW_LEN], lens[j], &mux_raw[j]);
+            }
+        }
+
+        for (size_t s = 0; s < plans[i].size(); s++) {
+            auto &p = plans[i][s];
+            auto &col = c.values[s];
+            col.resize(n);
+            c.signals.push_back(msgs[i].signals[s].name);
+            extract_column(p, rows.data(), lens.data(), n, col.data());
+            if (p.mux >= 0) {
+                for (size_t j = 0; j < n; j++) {
+                    if (ms < 0 || mux_raw[j] != static_cast<uint64_t>(p.mux)) {
+                        col[j] = NaN;
+                    }
+                }
+            }
+        }
+        ret.push_back(std::move(c));
+    }
+    return ret;
+}
+
+};
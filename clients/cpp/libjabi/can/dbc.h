@@ -0,0 +1,99 @@
+#ifndef LIBJABI_CAN_DBC_H
+#define LIBJABI_CAN_DBC_H
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <libjabi/device.h>
+
+namespace jabi {
+
+enum class DBCValueType {
+    INTEGER = 0,
+    FLOAT   = 1, // IEEE single, 32 bit signals
+    DOUBLE  = 2, // IEEE double, 64 bit signals
+};
+
+struct DBCSignal {
+    std::string  name;
+    int          start;         // as written in the DBC, msb for big endian
+    int          len;
+    bool         little_endian; // @1
+    bool         is_signed;
+    double       factor;
+    double       offset;
+    double       min;
+    double       max;
+    std::string  unit;
+    bool         is_mux;        // M, selects which muxed signals are present
+    int          mux;           // mN, -1 if always present
+    DBCValueType type;
+};
+
+struct DBCMessage {
+    int  id;
+    bool ext;
+    std::string name;
+    int  dlc;
+    std::vector<DBCSignal> signals;
+};
+
+struct DBCColumns { // one message's frames from a batch, one column per signal
+    int  id;
+    bool ext;
+    std::string name;
+    std::vector<uint64_t> timestamps; // from the frames, 0 unless read w/ timestamps
+    std::vector<std::string> signals;
+    std::vector<std::vector<double>> values; // [signal][frame], NaN if absent or frame short
+};
+
+/* Loads a DBC and compiles each signal into an extraction plan (byte offset,
+ * shift, mask and scaling) once, so decoding is loads and shifts. Batches are
+ * grouped by message and decoded a column at a time over a packed payload
+ * matrix. Byte order and value type are picked once per column, the per frame
+ * loop only selects NaN for frames too short for the signal.
+ */
+class DBC {
+public:
+    static DBC load(const std::string &path);
+    static DBC parse(const std::string &text);
+
+    const std::vector<DBCMessage> &messages() const { return msgs; }
+    const DBCMessage *find(int id, bool ext) const;
+
+    std::map<std::string, double> decode(const CANMessage &msg) const; // empty if unknown
+    std::vector<DBCColumns> decode(const std::vector<CANMessage> &msgs) const; // known ids only
+
+private:
+    struct plan_t {
+        uint8_t  byte0;    // first byte touched
+        uint8_t  nbytes;   // bytes touched, up to 9
+        uint8_t  shift;    // right shift after loading
+        bool     little_endian;
+        bool     is_signed;
+        uint8_t  len;
+        uint64_t mask;
+        double   factor;
+        double   offset;
+        int      mux;      // -1 if always present
+        DBCValueType type;
+    };
+
+    static uint64_t key(int id, bool ext) {
+        return (static_cast<uint64_t>(ext) << 32) | static_cast<uint32_t>(id);
+    }
+    static plan_t compile(const DBCSignal &sig);
+    static double extract(const plan_t &p, const uint8_t *row, size_t len, uint64_t *raw=nullptr);
+    static void extract_column(const plan_t &p, const uint8_t *rows, const size_t *lens, size_t n,
+                               double *out); // rows are ROW_LEN apart
+
+    std::vector<DBCMessage> msgs;
+    std::vector<std::vector<plan_t>> plans; // parallel to msgs[i].signals
+    std::vector<int> mux_signal;            // per message, -1 if not multiplexed
+    std::unordered_map<uint64_t, size_t> index;
+};
+
+};
+
+#endif // LIBJABI_CAN_DBC_H
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <stdexcept>
+#include "receiver.h"
+
+namespace jabi {
+
+CANReceiver::CANReceiver(Device dev, std::vector<int> idxs, bool timestamps,
+                         std::chrono::microseconds poll)
+:
+    dev(dev), idxs(idxs), timestamps(timestamps), poll(poll), table(std::make_shared<table_t>())
+{}
+
+CANReceiver::~CANReceiver() {
+    try {
+        stop();
+    } catch (...) {} // nowhere to report it
+}
+
+int CANReceiver::subscribe(int id, bool ext, Callback cb, int idx) {
+    auto sub = std::make_shared<subscriber_t>();
+    sub->idx = idx;
+    sub->id = id;
+    sub->ext = ext;
+    sub->cb = cb;
+    return add(sub);
+}
+
+std::pair<int, std::shared_ptr<CANQueue>> CANReceiver::subscribe_queue(int id, bool ext,
+        size_t capacity, int idx) {
+    auto sub = std::make_shared<subscriber_t>();
+    sub->idx = idx;
+    sub->id = id;
+    sub->ext = ext;
+    sub->queue = std::make_shared<CANQueue>(capacity);
+    int handle = add(sub);
+    return {handle, sub->queue};
+}
+
+int CANReceiver::add(std::shared_ptr<subscriber_t> sub) {
+    std::scoped_lock lk(table_lock);
+    auto t = std::make_shared<table_t>(*table);
+    sub->handle = next_handle++;
+    if (sub->id < 0) {
+        t->any.push_back(sub);
+    } else {
+        t->by_id[key(sub->idx, sub->id, sub->ext)].push_back(sub);
+    }
+    t->all.push_back(sub);
+    table = t;
+    return sub->handle;
+}
+
+void CANReceiver::unsubscribe(int handle) {
+    std::scoped_lock lk(table_lock);
+    auto t = std::make_shared<table_t>(*table);
+    auto match = [&](const std::shared_ptr<subscriber_t> &s) { return s->handle == handle; };
+    auto drop = [&](std::vector<std::shared_ptr<subscriber_t>> &v) {
+        v.erase(std::remove_if(v.begin(), v.end(), match), v.end());
+    };
+    for (auto it = t->by_id.begin(); it != t->by_id.end();) {
+        drop(it->second);
+        it = it->second.empty() ? t->by_id.erase(it) : std::next(it);
+    }
+    drop(t->any);
+    drop(t->all);
+    table = t;
+}
+
+std::vector<CANSubscriberStats> CANReceiver::stats() {
+    std::shared_ptr<const table_t> t;
+    {
+        std::scoped_lock lk(table_lock);
+        t = table;
+    }
+    std::vector<CANSubscriberStats> ret;
+    for (auto &s : t->all) {
+        ret.push_back(CANSubscriberStats{
+            .handle    = s->handle,
+            .idx       = s->idx,
+            .id        = s->id,
+            .ext       = s->ext,
+            .delivered = s->delivered,
+            .overflows = s->overflows,
+        });
+    }
+    return ret;
+}
+
+void CANReceiver::start() {
+    if (thread.joinable()) {
+        throw std::runtime_error("receiver already started");
+    }
+    done = false;
+    error = nullptr;
+    thread = std::thread(&CANReceiver::run, this);
+}
+
+void CANReceiver::stop() {
+    if (thread.joinable()) {
+        done = true;
+        thread.join();
+    }
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void CANReceiver::dispatch(const table_t &t, int idx, const CANMessage &msg) {
+    auto deliver = [&](const std::shared_ptr<subscriber_t> &s) {
+        if (s->queue) {
+            if (!s->queue->push(msg)) {
+                s->overflows++;
+                return;
+            }
+        } else {
+            s->cb(msg);
+        }
+        s->delivered++;
+    };
+
+    auto subs = t.by_id.find(key(idx, msg.id, msg.ext));
+    if (subs != t.by_id.end()) {
+        for (auto &s : subs->second) {
+            deliver(s);
+        }
+    }
+    for (auto &s : t.any) {
+        if (s->idx == idx) {
+            deliver(s);
+        }
+    }
+}
+
+void CANReceiver::run() {
+    std::vector<CANMessage> msgs;
+    try {
+        while (!done) {
+            bool more = false;
+            for (int idx : idxs) {
+                msgs.clear();
+                int left = dev.can_read_many(msgs, 0, idx, timestamps);
+                more |= left > 0;
+
+                std::shared_ptr<const table_t> t;
+                {
+                    std::scoped_lock lk(table_lock);
+                    t = table;
+                }
+                for (auto &m : msgs) {
+                    dispatch(*t, idx, m);
+                }
+            }
+            if (!more) {
+                std::this_thread::sleep_for(poll); // drained, let the device queue fill
+            }
+        }
+    } catch (...) {
+        error = std::current_exception();
+        done = true;
+    }
+}
+
+};
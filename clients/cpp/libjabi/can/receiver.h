@@ -0,0 +1,100 @@
+#ifndef LIBJABI_CAN_RECEIVER_H
+#define LIBJABI_CAN_RECEIVER_H
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <libjabi/device.h>
+#include <libjabi/spsc_queue.h>
+
+namespace jabi {
+
+using CANQueue = SPSCQueue<CANMessage>;
+
+struct CANSubscriberStats {
+    int      handle;
+    int      idx;
+    int      id;        // -1 for every id
+    bool     ext;
+    uint64_t delivered;
+    uint64_t overflows; // queue subscribers only, frames dropped while full
+};
+
+/* Drains CAN instances in a background thread w/ can_read_many and fans the
+ * frames out by id, so consumers in one process stop stealing each other's
+ * frames. Nothing else should call can_read on those instances meanwhile.
+ * Callbacks run on the receiver thread, keep them short.
+ */
+class CANReceiver {
+public:
+    using Callback = std::function<void(const CANMessage&)>;
+
+    CANReceiver(Device dev, std::vector<int> idxs={0}, bool timestamps=false,
+                std::chrono::microseconds poll=std::chrono::milliseconds(1));
+    ~CANReceiver();
+
+    CANReceiver(const CANReceiver&) = delete;
+    CANReceiver &operator=(const CANReceiver&) = delete;
+
+    // id of -1 receives every frame on the instance, returns a handle
+    int subscribe(int id, bool ext, Callback cb, int idx=0);
+    std::pair<int, std::shared_ptr<CANQueue>> subscribe_queue(int id, bool ext,
+        size_t capacity=1024, int idx=0);
+    void unsubscribe(int handle);
+    std::vector<CANSubscriberStats> stats();
+
+    void start();
+    void stop(); // rethrows whatever stopped the thread early
+    bool running() { return thread.joinable() && !done; }
+
+private:
+    struct subscriber_t {
+        int handle;
+        int idx;
+        int id;
+        bool ext;
+        Callback cb;
+        std::shared_ptr<CANQueue> queue;
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> overflows{0};
+    };
+
+    // copied on every change, receiver thread dispatches off a snapshot
+    struct table_t {
+        std::unordered_map<uint64_t, std::vector<std::shared_ptr<subscriber_t>>> by_id;
+        std::vector<std::shared_ptr<subscriber_t>> any;
+        std::vector<std::shared_ptr<subscriber_t>> all; // by handle order
+    };
+
+    static uint64_t key(int idx, int id, bool ext) {
+        return (static_cast<uint64_t>(idx) << 32) | (static_cast<uint64_t>(ext) << 31) |
+               (static_cast<uint32_t>(id) & 0x1FFFFFFF);
+    }
+
+    int add(std::shared_ptr<subscriber_t> sub);
+    void dispatch(const table_t &table, int idx, const CANMessage &msg);
+    void run();
+
+    Device dev;
+    std::vector<int> idxs;
+    bool timestamps;
+    std::chrono::microseconds poll;
+
+    std::mutex table_lock;
+    std::shared_ptr<const table_t> table;
+    int next_handle = 0;
+
+    std::thread thread;
+    std::atomic<bool> done{false};
+    std::exception_ptr error;
+};
+
+};
+
+#endif // LIBJABI_CAN_RECEIVER_H
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <memory>
 #include <vector>
+#include <libjabi/static_vector.h>
 
 namespace jabi {
 
@@ -11,6 +12,13 @@ namespace jabi {
 
 class Interface;
 
+struct OutputStats {
+    uint64_t sent;      // updates applied
+    uint64_t dropped;   // updates replaced by a newer one before being sent
+    double latency;     // seconds from submit to apply, last update
+    double max_latency;
+};
+
 /* Metadata */
 enum class InstID {
     METADATA = PERIPH_METADATA_ID,
@@ -25,26 +33,143 @@ enum class InstID {
     LIN      = PERIPH_LIN_ID,
 };
 
+struct RXBuffer {
+    InstID id;
+    int idx;
+    size_t size; // bytes
+};
+
+struct RXArena {
+    size_t size; // bytes, shared by all rx buffers
+    size_t free;
+    std::vector<RXBuffer> buffers;
+};
+
+struct FuncStats {
+    uint64_t calls;
+    double time; // seconds, cumulative
+};
+
+struct PeriphStats { // counters since boot, diff them across a capture
+    uint64_t rx;         // frames received, bytes for uart
+    uint64_t rx_dropped;
+    size_t rx_high;      // queue high water mark, bytes
+    uint64_t busy;       // requests rejected as busy
+    std::vector<FuncStats> funcs; // by function id, shared by all instances
+};
+
+struct IfaceStats {
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t errors;
+};
+
+struct LinkStats { // sink/source driven back to back, no peripheral work
+    uint64_t count;     // requests per direction
+    double tx_rate;     // bytes/s, host to device payload
+    double rx_rate;     // bytes/s, device to host payload
+    double tx_latency;  // seconds per sink request, mean
+    double rx_latency;  // seconds per source request, mean
+    uint64_t errors;    // source responses w/ a bad pattern or sequence gap
+};
+
 /* CAN */
+constexpr size_t CAN_MAX_LEN = 64;
+
 enum class CANMode {
     NORMAL     = 0,
     LOOPBACK   = 1,
     LISTENONLY = 2,
 };
 
+struct CANFilter {
+    int  id;
+    int  id_mask;
+    bool ext;
+};
+
 struct CANState {
     int state;
     int tx_err;
     int rx_err;
 };
 
+struct CANIdCount {
+    int id;
+    bool ext;
+    uint64_t count; // upper bound once the device had to evict an id
+};
+
+struct CANBusStats { // rx counts every frame unless filtered is set
+    uint64_t rx_frames; // since boot
+    uint64_t rx_bytes;
+    uint64_t tx_frames;
+    uint64_t tx_bytes;
+    double rx_frame_rate; // per second, over the last second
+    double rx_byte_rate;
+    double tx_frame_rate;
+    double tx_byte_rate;
+    double bus_load; // 0 to 1, ignores bit stuffing
+    uint64_t bit0_errors; // error frames by type, 0 unless device has CONFIG_CAN_STATS
+    uint64_t bit1_errors;
+    uint64_t stuff_errors;
+    uint64_t crc_errors;
+    uint64_t form_errors;
+    uint64_t ack_errors;
+    uint64_t rx_overruns;
+    uint64_t error_warning; // times entered each state
+    uint64_t error_passive;
+    uint64_t bus_off;
+    bool filtered; // filters or routes narrow what's received, rx counts only cover those frames
+    std::vector<CANIdCount> top_ids; // most frequent first
+};
+
+struct CANTxStats { // counters since boot
+    uint64_t queued;
+    uint64_t sent;
+    uint64_t failed;
+    size_t pending; // queued or in flight
+};
+
+struct CANRoute { // frames matching id/mask go out on dst as received
+    int  id           = 0;
+    int  id_mask      = 0;
+    bool ext          = false;
+    int  dst          = 0;
+    int  rewrite_mask = 0; // id bits taken from new_id
+    int  new_id       = 0;
+};
+
+struct CANRouteStats {
+    int      route;
+    int      dst;
+    uint64_t forwarded;
+    uint64_t dropped; // dst tx queue full
+};
+
+struct ISOTPConfig { // device answers flow control and paces frames
+    int  tx_id       = 0;
+    int  rx_id       = 0;
+    bool ext         = false;
+    bool fd          = false;
+    bool brs         = false;
+    int  tx_dl       = 0; // FD frame length, 0 for 8 or 64 if fd
+    bool ext_addr    = false;
+    int  tx_ext_addr = 0;
+    int  rx_ext_addr = 0;
+    int  bs          = 0; // sent in our flow control
+    int  stmin       = 0;
+};
+
 struct CANMessage {
     int  id;
     bool ext;
     bool fd;
     bool brs;
     bool rtr;
-    std::vector<uint8_t> data;
+    StaticVector<uint8_t, CAN_MAX_LEN> data;
+    uint64_t timestamp;    // us since device boot at rx, 0 unless read w/ timestamps or rx'd before the first such read
+    uint16_t hw_timestamp; // controller counter if it has one
 
     CANMessage();
     CANMessage(int id, int req_len, bool fd=false, bool brs=false);
@@ -53,6 +178,30 @@ struct CANMessage {
 
 std::ostream &operator<<(std::ostream &os, CANMessage const &m);
 
+enum class CANChecksum {
+    NONE           = 0,
+    XOR            = 1,
+    SUM            = 2,
+    CRC8_SAE_J1850 = 3,
+};
+
+struct CANCyclic { // sent by the device on its own, no host traffic
+    CANMessage  msg;
+    int         period_us     = 0;
+    int         offset_us     = 0; // until the first send, new slots only
+    int         counter_byte  = 0;
+    int         counter_bits  = 0; // 0 for no counter, else low bits count up
+    int         checksum_byte = 0;
+    CANChecksum checksum      = CANChecksum::NONE; // over every other byte
+};
+
+struct CANCyclicStats {
+    int      slot;
+    int      period_us;
+    uint64_t sent;
+    uint64_t missed; // tx queue full or a whole period late
+};
+
 /* I2C */
 enum class I2CFreq {
     STANDARD  = 0, // 100kHz
@@ -94,6 +243,8 @@ enum class UARTStop {
 };
 
 /* LIN */
+constexpr size_t LIN_MAX_LEN = 8;
+
 enum class LINMode {
     COMMANDER = 0,
     RESPONDER = 1,
@@ -113,7 +264,7 @@ struct LINStatus {
 struct LINMessage {
     int id;
     LINChecksum type;
-    std::vector<uint8_t> data;
+    StaticVector<uint8_t, LIN_MAX_LEN> data;
 
     LINMessage();
     LINMessage(int id, std::vector<uint8_t> data, LINChecksum type=LINChecksum::ENHANCED);
@@ -131,14 +282,50 @@ public:
     size_t req_max_size();
     size_t resp_max_size();
     std::vector<uint8_t> custom(std::vector<uint8_t> data);
+    RXArena rx_arena();
+    void set_rx_arena(std::vector<RXBuffer> buffers); // unlisted keep size, changed ones are emptied
+    PeriphStats periph_stats(InstID id, int idx=0);
+    std::vector<IfaceStats> iface_stats(); // device's interfaces, usb first
+    std::string log_read(); // drains buffered device log messages
+    void sink(std::vector<uint8_t> data); // discarded by device
+    std::vector<uint8_t> source(); // seq counter then pattern, fills response
+    LinkStats link_test(size_t count=100);
+
+    /* Connection */
+    void set_auto_reconnect(bool enable); // reopen the same device and replay config on link errors
+    void reconnect();
+    void set_skip_redundant(bool enable); // skip settings identical to the last applied
+    void invalidate_shadow();
+    void invalidate_shadow(InstID id, int idx=0);
+    void set_coalesce_reads(bool enable, double max_age=0.0); // seconds, share gpio/adc reads
+    void set_combine_writes(bool enable); // gpio/pwm/dac writes only send latest value when busy
+    void flush_writes(); // rethrows a failed combined write
+    OutputStats write_stats(InstID id, int idx);
+    void set_tagged(bool enable); // requests from other threads don't wait behind slow ones
 
     /* CAN */
     void can_set_filter(int id, int id_mask, int idx=0);
+    size_t can_set_filters(std::vector<CANFilter> filters, int idx=0); // num w/ their own hardware filter
     void can_set_rate(int bitrate, int bitrate_data, int idx=0);
     void can_set_mode(CANMode mode, int idx=0);
     CANState can_state(int idx=0);
     void can_write(CANMessage msg, int idx=0);
     int can_read(CANMessage &msg, int idx=0);
+    size_t can_read(std::vector<CANMessage> &msgs, size_t max_msgs, int idx=0);
+    int can_read_many(std::vector<CANMessage> &msgs, size_t max_msgs=0, int idx=0,
+        bool timestamps=false); // appends, -1 if none
+    size_t can_write_many(const std::vector<CANMessage> &msgs, int idx=0); // num queued, rest didn't fit
+    CANTxStats can_tx_stats(int idx=0);
+    CANBusStats can_bus_stats(bool reset_ids=false, int idx=0);
+    void can_cyclic_set(int slot, CANCyclic entry, int idx=0); // running slots keep phase
+    void can_cyclic_remove(int slot, int idx=0);
+    std::vector<CANCyclicStats> can_cyclic_stats(int idx=0);
+    void can_route_set(int route, CANRoute cfg, int idx=0); // idx is the source
+    void can_route_remove(int route, int idx=0);
+    std::vector<CANRouteStats> can_route_stats(int idx=0);
+    void isotp_bind(ISOTPConfig cfg, int idx=0); // refused while can filters or routes cover rx_id, like the default accept all
+    void isotp_send(std::vector<uint8_t> data, int idx=0); // returns once sent
+    std::vector<uint8_t> isotp_recv(int timeout_ms=1000, int idx=0); // empty if none
 
     /* I2C */
     void i2c_set_freq(I2CFreq preset, int idx=0);
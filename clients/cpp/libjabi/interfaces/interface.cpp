@@ -0,0 +1,530 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "interface.h"
+
+#define RECONNECT_TIMEOUT std::chrono::milliseconds(5000)
+#define RECONNECT_POLL    std::chrono::milliseconds(10)
+
+namespace jabi {
+
+#include <jabi/peripherals.h>
+#include <jabi/peripherals/can.h>
+#include <jabi/peripherals/i2c.h>
+#include <jabi/peripherals/gpio.h>
+#include <jabi/peripherals/pwm.h>
+#include <jabi/peripherals/adc.h>
+#include <jabi/peripherals/dac.h>
+#include <jabi/peripherals/spi.h>
+#include <jabi/peripherals/uart.h>
+#include <jabi/peripherals/lin.h>
+
+#define SHADOW_REPLAY_WINDOW 2 // requests sent ahead of their responses, fits the default JABI_REQ_BUFFERS
+
+/* Config shadow, settings the device forgets on reset. Outputs aren't kept,
+ * a setpoint replayed after the fact may well be stale, only gpio set_mode's
+ * initial value follows the pin's writes so its mode comes back w/ them.
+ * Only the latest request per key is kept, replayed in order applied.
+ */
+static bool shadow_tracked(const iface_req_t &r) {
+    switch (r.periph_id) {
+        case PERIPH_CAN_ID:
+            return r.periph_fn == CAN_SET_FILTER_ID || r.periph_fn == CAN_SET_FILTERS_ID ||
+                   r.periph_fn == CAN_SET_RATE_ID || r.periph_fn == CAN_SET_STYLE_ID;
+        case PERIPH_I2C_ID:  return r.periph_fn == I2C_SET_FREQ_ID;
+        case PERIPH_GPIO_ID: return r.periph_fn == GPIO_SET_MODE_ID;
+        case PERIPH_SPI_ID:
+            return r.periph_fn == SPI_SET_FREQ_ID || r.periph_fn == SPI_SET_MODE_ID ||
+                   r.periph_fn == SPI_SET_BITORDER_ID;
+        case PERIPH_UART_ID: return r.periph_fn == UART_SET_CONFIG_ID;
+        case PERIPH_LIN_ID:
+            return r.periph_fn == LIN_SET_MODE_ID || r.periph_fn == LIN_SET_RATE_ID ||
+                   r.periph_fn == LIN_SET_FILTER_ID;
+        default: return false;
+    }
+}
+
+/* Never skipped as redundant: set_filters has a response, and gpio set_mode
+ * also drives the initial value, which a write since may have changed
+ */
+static bool shadow_never_skip(const iface_req_t &r) {
+    return (r.periph_id == PERIPH_CAN_ID  && r.periph_fn == CAN_SET_FILTERS_ID) ||
+           (r.periph_id == PERIPH_GPIO_ID && r.periph_fn == GPIO_SET_MODE_ID);
+}
+
+static bool shadow_output(const iface_req_t &r) { // setpoints, not settings
+    return (r.periph_id == PERIPH_GPIO_ID && r.periph_fn == GPIO_WRITE_ID) ||
+           (r.periph_id == PERIPH_PWM_ID  && r.periph_fn == PWM_WRITE_ID)  ||
+           (r.periph_id == PERIPH_DAC_ID  && r.periph_fn == DAC_WRITE_ID);
+}
+
+static uint64_t shadow_key(uint16_t periph_id, uint16_t periph_idx, uint16_t fn, uint8_t sub) {
+    return (static_cast<uint64_t>(periph_id) << 48) | (static_cast<uint64_t>(periph_idx) << 32) |
+           (static_cast<uint64_t>(fn) << 16) | sub;
+}
+
+static uint64_t shadow_key(const iface_dynamic_req_t &r) {
+    uint16_t fn = r.msg.periph_fn;
+    uint8_t sub = 0;
+    if (r.msg.periph_id == PERIPH_CAN_ID && fn == CAN_SET_FILTER_ID) {
+        fn = CAN_SET_FILTERS_ID; // either replaces the other
+    } else if (r.msg.periph_id == PERIPH_LIN_ID && fn == LIN_SET_FILTER_ID) {
+        sub = r.payload.at(0); // one filter per LIN id
+    }
+    return shadow_key(r.msg.periph_id, r.msg.periph_idx, fn, sub);
+}
+
+/* Read coalescing, concurrent identical polls share one request */
+static bool coalescable(const iface_dynamic_req_t &req) {
+    return req.payload.empty() &&
+        ((req.msg.periph_id == PERIPH_GPIO_ID && req.msg.periph_fn == GPIO_READ_ID) ||
+         (req.msg.periph_id == PERIPH_ADC_ID  && req.msg.periph_fn == ADC_READ_ID));
+}
+
+static uint64_t coalesce_key(const iface_req_t &r) {
+    return (static_cast<uint64_t>(r.periph_id) << 32) |
+           (static_cast<uint64_t>(r.periph_idx) << 16) | r.periph_fn;
+}
+
+iface_dynamic_resp_t Interface::send_request(iface_dynamic_req_t req) {
+    bool combine;
+    std::exception_ptr error;
+    {
+        std::scoped_lock lk(combine_lock);
+        if ((combine = combine_writes && shadow_output(req.msg))) {
+            combined_write_t &w = writes[coalesce_key(req.msg)];
+            if (w.pending) {
+                w.stats.dropped++;
+            } else {
+                num_pending++;
+            }
+            w.req = req;
+            w.pending = true;
+            w.submitted = std::chrono::steady_clock::now();
+            std::swap(error, w.error);
+        }
+    }
+    if (combine) {
+        invalidate_reads(req.msg);
+        try_flush_writes(); // sends now unless link busy
+        if (error) {
+            std::rethrow_exception(error); // from an earlier update of this output
+        }
+        return iface_dynamic_resp_t{};
+    }
+
+    bool coalesce;
+    {
+        std::scoped_lock lk(coalesce_lock);
+        coalesce = coalesce_reads && coalescable(req);
+    }
+    if (!coalesce) {
+        invalidate_reads(req.msg); // anything else on the instance may change the value
+    }
+    return coalesce ? send_request_coalesced(req) : send_request_locked(req);
+}
+
+iface_dynamic_resp_t Interface::send_request_coalesced(iface_dynamic_req_t req) {
+    std::promise<iface_dynamic_resp_t> promise;
+    std::shared_future<iface_dynamic_resp_t> shared;
+    coalesced_read_t *r;
+    uint64_t gen = 0;
+    {
+        std::scoped_lock lk(coalesce_lock);
+        r = &reads[coalesce_key(req.msg)];
+        if (r->result.valid() && (r->in_flight ||
+                std::chrono::steady_clock::now() - r->time <= coalesce_max_age)) {
+            shared = r->result;
+        } else {
+            r->result = promise.get_future().share();
+            r->in_flight = true;
+            gen = ++r->gen;
+        }
+    }
+    if (shared.valid()) {
+        return shared.get(); // in flight or still fresh
+    }
+
+    try {
+        iface_dynamic_resp_t resp = send_request_locked(req);
+        promise.set_value(resp);
+        std::scoped_lock lk(coalesce_lock);
+        if (r->gen == gen) { // not invalidated or replaced meanwhile
+            r->in_flight = false;
+            r->time = std::chrono::steady_clock::now();
+        }
+        return resp;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        std::scoped_lock lk(coalesce_lock);
+        if (r->gen == gen) {
+            r->in_flight = false;
+            r->result = {}; // don't cache failures
+        }
+        throw;
+    }
+}
+
+void Interface::invalidate_reads(const iface_req_t &req) {
+    std::scoped_lock lk(coalesce_lock);
+    if (!coalesce_reads) {
+        return;
+    }
+    for (auto &[key, r] : reads) {
+        if ((key >> 16) == (coalesce_key(req) >> 16)) {
+            r.result = {}; // waiters already joined keep their future
+            r.in_flight = false;
+            r.gen++;
+        }
+    }
+}
+
+iface_dynamic_resp_t Interface::send_request_locked(iface_dynamic_req_t req) {
+    req_hold_t hold(*this);
+    return send_request_held(req, hold.lk);
+}
+
+iface_dynamic_resp_t Interface::send_request_held(iface_dynamic_req_t req,
+                                                  std::unique_lock<std::mutex> &lk) {
+    bool tracked = shadow_tracked(req.msg) && !req.payload.empty();
+    if (tracked && skip_redundant && !shadow_never_skip(req.msg)) {
+        auto e = shadow.find(shadow_key(req));
+        if (e != shadow.end() && e->second.req.payload == req.payload) {
+            iface_dynamic_resp_t resp{}; // already applied, nothing to send
+            return resp;
+        }
+    }
+
+    auto exchange = [&]() { return tagged ? transfer_tagged(req, lk) : transfer(req); };
+    iface_dynamic_resp_t resp;
+    try {
+        uint64_t gen = link_gen;
+        try {
+            resp = exchange();
+        } catch (const LinkError&) {
+            if (!auto_reconnect) {
+                throw;
+            }
+            if (gen == link_gen) { // else another caller reconnected while we waited
+                recover(); // note retried request may have been applied already
+            }
+            resp = exchange();
+        }
+    } catch (const LinkError&) {
+        throw;
+    } catch (const std::runtime_error&) {
+        if (tracked) {
+            shadow.erase(shadow_key(req)); // device state unknown now
+        }
+        throw;
+    }
+
+    if (tracked) {
+        shadow[shadow_key(req)] = shadow_entry_t{req, shadow_seq++};
+    } else if (req.msg.periph_id == PERIPH_GPIO_ID && req.msg.periph_fn == GPIO_WRITE_ID &&
+               req.payload.size() == sizeof(gpio_write_req_t)) {
+        auto e = shadow.find(shadow_key(PERIPH_GPIO_ID, req.msg.periph_idx, GPIO_SET_MODE_ID, 0));
+        if (e != shadow.end() && e->second.req.payload.size() == sizeof(gpio_set_mode_req_t)) {
+            e->second.req.payload[offsetof(gpio_set_mode_req_t, init_val)] = req.payload[0];
+        }
+    }
+    return resp;
+}
+
+iface_dynamic_resp_t Interface::transfer(iface_dynamic_req_t req) {
+    send(req);
+    iface_dynamic_resp_t resp = recv();
+    if (resp.msg.retcode != 0) {
+        throw std::runtime_error("bad response " + std::to_string(resp.msg.retcode));
+    }
+    return resp;
+}
+
+/* Tagged requests, the device answers each as its peripheral finishes. The
+ * link is only held to send, then whichever waiter finds nobody receiving
+ * reads responses and hands them out by tag until its own arrives.
+ */
+iface_dynamic_resp_t Interface::transfer_tagged(iface_dynamic_req_t req,
+                                                std::unique_lock<std::mutex> &lk) {
+    tagged_wait_t wait;
+    uint16_t tag;
+    {
+        std::scoped_lock tl(tag_lock);
+        do {
+            tag = next_tag++;
+        } while (waiting.count(tag));
+        waiting[tag] = &wait;
+    }
+
+    uint16_t le_tag = htole<uint16_t>(tag);
+    req.msg.periph_fn |= IFACE_FN_TAGGED;
+    req.payload.resize(req.payload.size() + IFACE_TAG_SIZE);
+    std::memcpy(&req.payload[req.payload.size() - IFACE_TAG_SIZE], &le_tag, IFACE_TAG_SIZE);
+    req.msg.payload_len = static_cast<uint16_t>(req.payload.size());
+    try {
+        send(req);
+    } catch (...) {
+        std::scoped_lock tl(tag_lock);
+        waiting.erase(tag);
+        throw;
+    }
+
+    lk.unlock(); // others can send while we wait
+    {
+        std::unique_lock tl(tag_lock);
+        while (!wait.done) {
+            if (receiving) {
+                tag_cv.wait(tl);
+                continue;
+            }
+            receiving = true;
+            tl.unlock();
+            iface_dynamic_resp_t resp;
+            std::exception_ptr error;
+            try {
+                resp = recv();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            tl.lock();
+            receiving = false;
+            if (error) {
+                fail_tagged(error); // stream is lost, nobody's response is coming
+            } else {
+                route_tagged(std::move(resp));
+            }
+            tag_cv.notify_all();
+        }
+    }
+    lk.lock();
+
+    if (wait.error) {
+        std::rethrow_exception(wait.error);
+    }
+    if (wait.resp.msg.retcode != 0) {
+        throw std::runtime_error("bad response " + std::to_string(wait.resp.msg.retcode));
+    }
+    return wait.resp;
+}
+
+void Interface::route_tagged(iface_dynamic_resp_t resp) {
+    if (resp.payload.size() < IFACE_TAG_SIZE) {
+        fail_tagged(std::make_exception_ptr(LinkError("untagged response")));
+        return;
+    }
+    uint16_t tag;
+    std::memcpy(&tag, &resp.payload[resp.payload.size() - IFACE_TAG_SIZE], IFACE_TAG_SIZE);
+    tag = letoh<uint16_t>(tag);
+    resp.payload.resize(resp.payload.size() - IFACE_TAG_SIZE);
+    resp.msg.payload_len = static_cast<uint16_t>(resp.payload.size());
+
+    auto w = waiting.find(tag);
+    if (w == waiting.end()) {
+        return; // caller already failed by a link reset
+    }
+    w->second->resp = std::move(resp);
+    w->second->done = true;
+    waiting.erase(w);
+}
+
+void Interface::fail_tagged(std::exception_ptr error) {
+    for (auto &[tag, w] : waiting) {
+        w->error = error;
+        w->done = true;
+    }
+    waiting.clear();
+}
+
+void Interface::set_tagged(bool enable) {
+    req_hold_t hold(*this);
+    std::unique_lock tl(tag_lock);
+    tag_cv.wait(tl, [&]() { return waiting.empty(); }); // untagged can't share the link w/ them
+    tagged = enable;
+}
+
+void Interface::reconnect() {
+    req_hold_t hold(*this);
+    recover();
+}
+
+void Interface::set_reconnect(bool enable, std::string serial) {
+    req_hold_t hold(*this);
+    auto_reconnect = enable;
+    if (!serial.empty()) {
+        this->serial = serial;
+    }
+}
+
+void Interface::set_skip_redundant(bool enable) {
+    req_hold_t hold(*this);
+    skip_redundant = enable;
+}
+
+void Interface::invalidate_shadow(int periph_id, int periph_idx) {
+    req_hold_t hold(*this);
+    for (auto e = shadow.begin(); e != shadow.end();) {
+        const iface_req_t &m = e->second.req.msg;
+        if ((periph_id  < 0 || m.periph_id  == periph_id) &&
+            (periph_idx < 0 || m.periph_idx == periph_idx)) {
+            e = shadow.erase(e);
+        } else {
+            ++e;
+        }
+    }
+}
+
+void Interface::set_coalesce_reads(bool enable, std::chrono::steady_clock::duration max_age) {
+    std::scoped_lock lk(coalesce_lock);
+    coalesce_reads = enable;
+    coalesce_max_age = max_age;
+    for (auto &[key, r] : reads) {
+        r.result = {};
+        r.in_flight = false;
+        r.gen++;
+    }
+}
+
+/* Write combining, last writer wins per output w/ one pending slot each */
+void Interface::set_combine_writes(bool enable) {
+    {
+        std::scoped_lock lk(combine_lock);
+        combine_writes = enable;
+    }
+    if (!enable) {
+        flush_writes();
+    }
+}
+
+void Interface::flush_writes() {
+    {
+        req_hold_t hold(*this);
+        drain_writes(hold.lk);
+    }
+    std::exception_ptr error;
+    {
+        std::scoped_lock lk(combine_lock);
+        for (auto &[key, w] : writes) {
+            if (w.error) {
+                std::swap(error, w.error);
+                break; // rest reported by the next flush or update of their output
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+OutputStats Interface::write_stats(int periph_id, int periph_idx) {
+    std::scoped_lock lk(combine_lock);
+    for (auto &[key, w] : writes) {
+        if (w.req.msg.periph_id == periph_id && w.req.msg.periph_idx == periph_idx) {
+            return w.stats;
+        }
+    }
+    return OutputStats{};
+}
+
+void Interface::try_flush_writes() noexcept {
+    while (true) {
+        {
+            std::scoped_lock lk(combine_lock);
+            if (num_pending == 0) {
+                return;
+            }
+        }
+        std::unique_lock lk(req_lock, std::try_to_lock);
+        if (!lk.owns_lock()) {
+            return; // current holder flushes once it releases, see req_hold_t
+        }
+        drain_writes(lk);
+    } // recheck, writes may have been submitted while draining
+}
+
+void Interface::drain_writes(std::unique_lock<std::mutex> &lk) {
+    while (true) {
+        iface_dynamic_req_t req;
+        std::chrono::steady_clock::time_point submitted;
+        {
+            std::scoped_lock lk(combine_lock);
+            auto w = std::find_if(writes.begin(), writes.end(),
+                [](auto &e) { return e.second.pending; });
+            if (w == writes.end()) {
+                return;
+            }
+            req = w->second.req;
+            submitted = w->second.submitted;
+            w->second.pending = false;
+            num_pending--;
+        }
+
+        std::exception_ptr error;
+        try {
+            send_request_held(req, lk);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        invalidate_reads(req.msg);
+
+        std::scoped_lock lk(combine_lock);
+        combined_write_t &w = writes[coalesce_key(req.msg)];
+        if (error) {
+            w.error = error;
+            continue;
+        }
+        double latency = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - submitted).count();
+        w.stats.sent++;
+        w.stats.latency = latency;
+        w.stats.max_latency = std::max(w.stats.max_latency, latency);
+    }
+}
+
+void Interface::recover() {
+    {
+        std::unique_lock tl(tag_lock);
+        tag_cv.wait(tl, [&]() { return !receiving; }); // recv times out on a dead link
+        fail_tagged(std::make_exception_ptr(LinkError("link reset")));
+        tag_cv.notify_all();
+    }
+    link_gen++;
+
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        try {
+            reopen();
+            replay_shadow();
+            return;
+        } catch (const LinkError&) {
+            if (std::chrono::steady_clock::now() - start > RECONNECT_TIMEOUT) {
+                throw LinkError("failed to reconnect to " + serial);
+            }
+            std::this_thread::sleep_for(RECONNECT_POLL);
+        }
+    }
+}
+
+/* Sent a window at a time w/o waiting on each response, untagged requests
+ * are answered in order. Entries the device rejects now are dropped
+ */
+void Interface::replay_shadow() {
+    std::vector<std::pair<uint64_t, uint64_t>> order; // seq, key
+    for (auto &[key, e] : shadow) {
+        order.emplace_back(e.seq, key);
+    }
+    std::sort(order.begin(), order.end());
+    for (size_t i = 0; i < order.size(); i += SHADOW_REPLAY_WINDOW) {
+        size_t num = std::min<size_t>(SHADOW_REPLAY_WINDOW, order.size() - i);
+        for (size_t j = 0; j < num; j++) {
+            send(shadow.at(order[i + j].second).req);
+        }
+        for (size_t j = 0; j < num; j++) {
+            if (recv().msg.retcode != 0) {
+                shadow.erase(order[i + j].second);
+            }
+        }
+    }
+}
+
+};
@@ -1,7 +1,14 @@
 #ifndef LIBJABI_INTERFACES_INTERFACE_H
 #define LIBJABI_INTERFACES_INTERFACE_H
 
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <map>
 #include <mutex>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <libjabi/byteorder.h>
 #include <libjabi/device.h>
@@ -20,21 +27,121 @@ struct iface_dynamic_resp_t {
     std::vector<uint8_t> payload;
 };
 
+// thrown when the link itself fails (device unplugged, timeout), not the request
+class LinkError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 class Interface {
 public:
     virtual ~Interface() = default;
 
-    virtual iface_dynamic_resp_t send_request(iface_dynamic_req_t req) = 0;
+    iface_dynamic_resp_t send_request(iface_dynamic_req_t req);
+    void reconnect();
+    void set_reconnect(bool enable, std::string serial);
+    void set_skip_redundant(bool enable);
+    void invalidate_shadow(int periph_id=-1, int periph_idx=-1); // -1 matches all
+    void set_coalesce_reads(bool enable, std::chrono::steady_clock::duration max_age);
+    void set_combine_writes(bool enable);
+    void flush_writes();
+    OutputStats write_stats(int periph_id, int periph_idx);
+    void set_tagged(bool enable);
 
     size_t get_req_max_size() { return req_max_size; }
     size_t get_resp_max_size() { return resp_max_size; }
 
 protected:
+    /* throw LinkError on link failures. send is called w/ req_lock held,
+     * recv by one thread at a time and returns whatever response is next
+     */
+    virtual void send(iface_dynamic_req_t req) = 0;
+    virtual iface_dynamic_resp_t recv() = 0;
+    virtual void reopen() = 0; // find and open the same device again, LinkError if it can't
+
     size_t req_max_size = REQ_PAYLOAD_MAX_SIZE;
     size_t resp_max_size = RESP_PAYLOAD_MAX_SIZE;
+    std::string serial; // from set_reconnect, for messages
     std::mutex req_lock;
 
     static Device make_device(std::shared_ptr<Interface> i) { return Device(i); }
+
+private:
+    struct coalesced_read_t {
+        std::shared_future<iface_dynamic_resp_t> result;
+        bool in_flight;
+        std::chrono::steady_clock::time_point time;
+        uint64_t gen; // bumped when invalidated, in flight results from before are stale
+    };
+
+    struct combined_write_t {
+        iface_dynamic_req_t req;
+        bool pending;
+        std::chrono::steady_clock::time_point submitted;
+        std::exception_ptr error; // rethrown on next submit
+        OutputStats stats;
+    };
+
+    // req_lock for the scope, combined writes submitted meanwhile are sent on release
+    struct req_hold_t {
+        Interface &iface;
+        std::unique_lock<std::mutex> lk;
+
+        explicit req_hold_t(Interface &iface) : iface(iface), lk(iface.req_lock) {}
+        ~req_hold_t() {
+            lk.unlock();
+            iface.try_flush_writes();
+        }
+    };
+
+    struct shadow_entry_t {
+        iface_dynamic_req_t req;
+        uint64_t seq; // replayed in the order applied
+    };
+
+    struct tagged_wait_t {
+        bool done = false;
+        iface_dynamic_resp_t resp;
+        std::exception_ptr error;
+    };
+
+    iface_dynamic_resp_t send_request_coalesced(iface_dynamic_req_t req);
+    void invalidate_reads(const iface_req_t &req); // anything on the instance
+    iface_dynamic_resp_t send_request_locked(iface_dynamic_req_t req);
+    // req_lock held by lk, released while waiting on tagged responses
+    iface_dynamic_resp_t send_request_held(iface_dynamic_req_t req, std::unique_lock<std::mutex> &lk);
+    iface_dynamic_resp_t transfer(iface_dynamic_req_t req); // req_lock held, untagged
+    iface_dynamic_resp_t transfer_tagged(iface_dynamic_req_t req, std::unique_lock<std::mutex> &lk);
+    void route_tagged(iface_dynamic_resp_t resp); // tag_lock held
+    void fail_tagged(std::exception_ptr error); // tag_lock held
+    void try_flush_writes() noexcept;
+    void drain_writes(std::unique_lock<std::mutex> &lk);
+    void recover(); // req_lock held
+    void replay_shadow(); // req_lock held
+
+    bool auto_reconnect = false;
+    bool skip_redundant = false;
+    std::map<uint64_t, shadow_entry_t> shadow; // applied config by shadow_key
+    uint64_t shadow_seq = 0;
+    uint64_t link_gen = 0; // bumped by recover
+
+    // tagged requests from many threads in flight, whoever waits reads for all
+    std::mutex tag_lock;
+    std::condition_variable tag_cv;
+    bool tagged = false;
+    bool receiving = false;
+    uint16_t next_tag = 0;
+    std::map<uint16_t, tagged_wait_t*> waiting;
+
+    std::mutex coalesce_lock;
+    bool coalesce_reads = false;
+    std::chrono::steady_clock::duration coalesce_max_age{};
+    std::map<uint64_t, coalesced_read_t> reads;
+
+    std::mutex combine_lock;
+    bool combine_writes = false;
+    size_t num_pending = 0;
+    std::map<uint64_t, combined_write_t> writes;
 };
 
 inline void iface_req_htole(iface_req_t &req) {
@@ -15,9 +15,26 @@
 
 namespace jabi {
 
+UARTInterface::UARTInterface(std::string port, int baud) : port(port), baud(baud) {
+    open_port();
+}
+
+UARTInterface::~UARTInterface() {
+    close_port();
+}
+
+void UARTInterface::reopen() {
+    close_port();
+    try {
+        open_port();
+    } catch (const std::runtime_error &e) {
+        throw LinkError(e.what());
+    }
+}
+
 #ifdef _WIN32
 
-UARTInterface::UARTInterface(std::string port, int baud) {
+void UARTInterface::open_port() {
     hFile = CreateFileA(
         static_cast<LPCSTR>(("\\\\.\\" + port).c_str()),
         GENERIC_READ | GENERIC_WRITE,
@@ -72,14 +89,19 @@ UARTInterface::UARTInterface(std::string port, int baud) {
     }    
 }
 
-UARTInterface::~UARTInterface() {
-    CloseHandle(hFile);
+void UARTInterface::close_port() {
+    if (hFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(hFile);
+        hFile = INVALID_HANDLE_VALUE;
+    }
 }
 
-iface_dynamic_resp_t UARTInterface::send_request(iface_dynamic_req_t req) {
-    std::scoped_lock lk(req_lock);
-
-    if (req.msg.payload_len > req_max_size ||
+void UARTInterface::send(iface_dynamic_req_t req) {
+    if (hFile == INVALID_HANDLE_VALUE) {
+        throw LinkError("COM port closed");
+    }
+    size_t max = req_max_size + ((req.msg.periph_fn & IFACE_FN_TAGGED) ? IFACE_TAG_SIZE : 0);
+    if (req.msg.payload_len > max ||
         req.msg.payload_len != req.payload.size()) {
         throw std::runtime_error("request payload size too large");
     }
@@ -89,7 +111,7 @@ iface_dynamic_resp_t UARTInterface::send_request(iface_dynamic_req_t req) {
     while (len) {
         DWORD sent_len;
         if (!WriteFile(hFile, buffer, len, &sent_len, NULL)) {
-            throw std::runtime_error("write failed");
+            throw LinkError("write failed");
         }
         len -= sent_len;
         buffer += sent_len;
@@ -99,7 +121,7 @@ iface_dynamic_resp_t UARTInterface::send_request(iface_dynamic_req_t req) {
     while (len) {
         DWORD sent_len;
         if (!WriteFile(hFile, buffer, len, &sent_len, NULL)) {
-            throw std::runtime_error("write failed");
+            throw LinkError("write failed");
         }
         len -= sent_len;
         buffer += sent_len;
@@ -108,40 +130,46 @@ iface_dynamic_resp_t UARTInterface::send_request(iface_dynamic_req_t req) {
     DWORD flags;
     COMSTAT comstat;
     if (!ClearCommError(hFile, &flags, &comstat)) {
-        throw std::runtime_error("failed to clear error?");
+        throw LinkError("failed to clear error?");
+    }
+}
+
+iface_dynamic_resp_t UARTInterface::recv() {
+    if (hFile == INVALID_HANDLE_VALUE) {
+        throw LinkError("COM port closed");
     }
 
     // only check timeout while waiting for bytes
     auto start = std::chrono::steady_clock::now();
     iface_dynamic_resp_t resp;
     resp.msg.payload_len = 0;
-    len = static_cast<DWORD>(IFACE_RESP_HDR_SIZE);
-    buffer = reinterpret_cast<char*>(&resp.msg);
+    DWORD len = static_cast<DWORD>(IFACE_RESP_HDR_SIZE);
+    auto buffer = reinterpret_cast<char*>(&resp.msg);
     while (len) {
         if (std::chrono::steady_clock::now() - start > UART_TIMEOUT) {
-            throw std::runtime_error("UART timeout");
+            throw LinkError("UART timeout");
         }
         DWORD recv_len;
         if (!ReadFile(hFile, buffer, len, &recv_len, NULL)) {
-            throw std::runtime_error("read failed");
+            throw LinkError("read failed");
         }
         len -= recv_len;
         buffer += recv_len;
     }
     iface_resp_letoh(resp.msg);
-    if (resp.msg.retcode != 0 || resp.msg.payload_len > resp_max_size) {
-        throw std::runtime_error("bad response " + std::to_string(resp.msg.retcode));
+    if (resp.msg.payload_len > resp_max_size + IFACE_TAG_SIZE) {
+        throw LinkError("bad response length " + std::to_string(resp.msg.payload_len));
     }
     resp.payload = std::vector<uint8_t>(resp.msg.payload_len, 0);
     len = static_cast<DWORD>(resp.payload.size());
     buffer = reinterpret_cast<char*>(resp.payload.data());
     while (len) {
         if (std::chrono::steady_clock::now() - start > UART_TIMEOUT) {
-            throw std::runtime_error("UART timeout");
+            throw LinkError("UART timeout");
         }
         DWORD recv_len;
         if (!ReadFile(hFile, buffer, len, &recv_len, NULL)) {
-            throw std::runtime_error("read failed");
+            throw LinkError("read failed");
         }
         len -= recv_len;
         buffer += recv_len;
@@ -152,7 +180,7 @@ iface_dynamic_resp_t UARTInterface::send_request(iface_dynamic_req_t req) {
 
 #else
 
-UARTInterface::UARTInterface(std::string port, int baud) {
+void UARTInterface::open_port() {
     if ((fd = open(port.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK)) < 0) {
         throw std::runtime_error("couldn't open port");
     }
@@ -203,13 +231,19 @@ UARTInterface::UARTInterface(std::string port, int baud) {
     tcflush(fd, TCIOFLUSH);
 }
 
-UARTInterface::~UARTInterface() {
-    close(fd);
+void UARTInterface::close_port() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
 }
 
-iface_dynamic_resp_t UARTInterface::send_request(iface_dynamic_req_t req) {
-    std::scoped_lock lk(req_lock);
-    if (req.msg.payload_len > req_max_size ||
+void UARTInterface::send(iface_dynamic_req_t req) {
+    if (fd < 0) {
+        throw LinkError("port closed");
+    }
+    size_t max = req_max_size + ((req.msg.periph_fn & IFACE_FN_TAGGED) ? IFACE_TAG_SIZE : 0);
+    if (req.msg.payload_len > max ||
         req.msg.payload_len != req.payload.size()) {
         throw std::runtime_error("request payload size bad");
     }
@@ -219,7 +253,7 @@ iface_dynamic_resp_t UARTInterface::send_request(iface_dynamic_req_t req) {
     while (len) {
         int sent_len;
         if ((sent_len = write(fd, buffer, len)) < 0) {
-            throw std::runtime_error("write failed");
+            throw LinkError("write failed");
         }
         len -= sent_len;
         buffer += sent_len;
@@ -229,43 +263,49 @@ iface_dynamic_resp_t UARTInterface::send_request(iface_dynamic_req_t req) {
     while (len) {
         int sent_len;
         if ((sent_len = write(fd, buffer, len)) < 0) {
-            throw std::runtime_error("write failed");
+            throw LinkError("write failed");
         }
         len -= sent_len;
         buffer += sent_len;
     }
+}
+
+iface_dynamic_resp_t UARTInterface::recv() {
+    if (fd < 0) {
+        throw LinkError("port closed");
+    }
 
     // only check timeout while waiting for bytes
     auto start = std::chrono::steady_clock::now();
     iface_dynamic_resp_t resp;
     resp.msg.payload_len = 0;
-    len = IFACE_RESP_HDR_SIZE;
-    buffer = reinterpret_cast<unsigned char*>(&resp.msg);
+    int len = IFACE_RESP_HDR_SIZE;
+    auto buffer = reinterpret_cast<unsigned char*>(&resp.msg);
     while (len) {
         if (std::chrono::steady_clock::now() - start > UART_TIMEOUT) {
-            throw std::runtime_error("UART timeout");
+            throw LinkError("UART timeout");
         }
         int recv_len;
         if ((recv_len = read(fd, buffer, len)) < 0) {
-            throw std::runtime_error("read failed");
+            throw LinkError("read failed");
         }
         len -= recv_len;
         buffer += recv_len;
     }
     iface_resp_letoh(resp.msg);
-    if (resp.msg.retcode != 0 || resp.msg.payload_len > resp_max_size) {
-        throw std::runtime_error("bad response " + std::to_string(resp.msg.retcode));
+    if (resp.msg.payload_len > resp_max_size + IFACE_TAG_SIZE) {
+        throw LinkError("bad response length " + std::to_string(resp.msg.payload_len));
     }
     resp.payload = std::vector<uint8_t>(resp.msg.payload_len, 0);
     len = resp.payload.size();
     buffer = reinterpret_cast<unsigned char*>(resp.payload.data());
     while (len) {
         if (std::chrono::steady_clock::now() - start > UART_TIMEOUT) {
-            throw std::runtime_error("UART timeout");
+            throw LinkError("UART timeout");
         }
         int recv_len;
         if ((recv_len = read(fd, buffer, len)) < 0) {
-            throw std::runtime_error("read failed");
+            throw LinkError("read failed");
         }
         len -= recv_len;
         buffer += recv_len;
@@ -13,16 +13,25 @@ class UARTInterface : public Interface {
 public:
     ~UARTInterface();
 
-    iface_dynamic_resp_t send_request(iface_dynamic_req_t req);
     static Device get_device(std::string port, int baud);
 
+protected:
+    void send(iface_dynamic_req_t req);
+    iface_dynamic_resp_t recv();
+    void reopen();
+
 private:
     UARTInterface(std::string port, int baud);
 
+    void open_port();
+    void close_port();
+
+    std::string port;
+    int baud;
 #ifdef _WIN32
-    HANDLE hFile;
+    HANDLE hFile = INVALID_HANDLE_VALUE;
 #else
-    int fd;
+    int fd = -1;
 #endif // _WIN32
 };
 
@@ -14,14 +14,23 @@ USBInterface::USBInterface(void *dev, int ifnum, int wMaxPacketSize,
 {}
 
 USBInterface::~USBInterface() {
-    libusb_release_interface(static_cast<libusb_device_handle*>(dev), ifnum);
-    libusb_close(static_cast<libusb_device_handle*>(dev));
+    close();
 }
 
-iface_dynamic_resp_t USBInterface::send_request(iface_dynamic_req_t req) {
-    std::scoped_lock lk(req_lock);
+void USBInterface::close() {
+    if (dev) {
+        libusb_release_interface(static_cast<libusb_device_handle*>(dev), ifnum);
+        libusb_close(static_cast<libusb_device_handle*>(dev));
+        dev = nullptr;
+    }
+}
 
-    if (req.msg.payload_len > req_max_size ||
+void USBInterface::send(iface_dynamic_req_t req) {
+    if (!dev) {
+        throw LinkError("USB device closed");
+    }
+    size_t max = req_max_size + ((req.msg.periph_fn & IFACE_FN_TAGGED) ? IFACE_TAG_SIZE : 0);
+    if (req.msg.payload_len > max ||
         req.msg.payload_len != req.payload.size()) {
         throw std::runtime_error("request payload size bad");
     }
@@ -29,7 +38,7 @@ iface_dynamic_resp_t USBInterface::send_request(iface_dynamic_req_t req) {
     iface_req_htole(req.msg);
 
     // transfer must be contiguous, allocate buffer from heap (MSVC complains about stack)
-    auto req_buffer = std::make_unique<uint8_t[]>(IFACE_REQ_HDR_SIZE + req_max_size);
+    auto req_buffer = std::make_unique<uint8_t[]>(IFACE_REQ_HDR_SIZE + req.payload.size());
     iface_req_t* req_msg = reinterpret_cast<iface_req_t*>(req_buffer.get());
     memcpy(req_msg, &req.msg, IFACE_REQ_HDR_SIZE);
     memcpy(req_msg->payload, req.payload.data(), req.payload.size());
@@ -38,35 +47,39 @@ iface_dynamic_resp_t USBInterface::send_request(iface_dynamic_req_t req) {
     int len = static_cast<int>(IFACE_REQ_HDR_SIZE + req.payload.size());
     if (libusb_bulk_transfer(static_cast<libusb_device_handle*>(dev), ep_out, reinterpret_cast<unsigned char*>(req_msg),
             len, &sent_len, USB_TIMEOUT_MS) < 0) {
-        throw std::runtime_error("USB transfer request failed");
+        throw LinkError("USB transfer request failed");
     }
     if (sent_len != len) {
-        throw std::runtime_error("wrong USB transfer request length");
+        throw LinkError("wrong USB transfer request length");
     }
     if (len % wMaxPacketSize == 0) { // manually send ZLP
         if (libusb_bulk_transfer(static_cast<libusb_device_handle*>(dev), ep_out, NULL, 0, NULL, USB_TIMEOUT_MS) < 0) {
-            throw std::runtime_error("USB transfer ZLP request failed");
+            throw LinkError("USB transfer ZLP request failed");
         }
     }
+}
+
+iface_dynamic_resp_t USBInterface::recv() {
+    if (!dev) {
+        throw LinkError("USB device closed");
+    }
 
     // transfer must be contiguous, allocate buffer from heap (MSVC complains about stack)
-    auto resp_buffer = std::make_unique<uint8_t[]>(IFACE_RESP_HDR_SIZE + resp_max_size);
+    size_t max_len = IFACE_RESP_HDR_SIZE + resp_max_size + IFACE_TAG_SIZE;
+    auto resp_buffer = std::make_unique<uint8_t[]>(max_len);
     iface_resp_t* resp_msg = reinterpret_cast<iface_resp_t*>(resp_buffer.get());
 
     int recv_len;
     resp_msg->payload_len = 0;
     if (libusb_bulk_transfer(static_cast<libusb_device_handle*>(dev), ep_in, reinterpret_cast<unsigned char*>(resp_msg),
-            static_cast<int>(IFACE_RESP_HDR_SIZE + resp_max_size), &recv_len, USB_TIMEOUT_MS) < 0) {
-        throw std::runtime_error("USB transfer response failed");
+            static_cast<int>(max_len), &recv_len, USB_TIMEOUT_MS) < 0) {
+        throw LinkError("USB transfer response failed");
     }
 
     iface_resp_letoh(*resp_msg);
 
     if (recv_len != static_cast<int>(IFACE_RESP_HDR_SIZE + resp_msg->payload_len)) {
-        throw std::runtime_error("wrong USB transfer response length");
-    }
-    if (resp_msg->retcode != 0 || resp_msg->payload_len > resp_max_size) {
-        throw std::runtime_error("bad response " + std::to_string(resp_msg->retcode));
+        throw LinkError("wrong USB transfer response length");
     }
 
     iface_dynamic_resp_t resp;
@@ -77,113 +90,188 @@ iface_dynamic_resp_t USBInterface::send_request(iface_dynamic_req_t req) {
     return resp;
 }
 
+// one context for the process, libusb_init() per poll would leak one each time
+static libusb_context *usb_context() {
+    static libusb_context *ctx = []() {
+        libusb_context *c;
+        if (libusb_init(&c) < 0) {
+            throw LinkError("libusb failed init");
+        }
+        return c;
+    }();
+    return ctx;
+}
+
+static std::vector<uint8_t> usb_port_path(libusb_device *udev) {
+    uint8_t ports[8]; // USB allows 7 tiers of hubs
+    int num = libusb_get_port_numbers(udev, ports, sizeof(ports));
+    std::vector<uint8_t> path = { libusb_get_bus_number(udev) };
+    path.insert(path.end(), ports, ports + (num > 0 ? num : 0));
+    return path;
+}
+
 /* Driver will attach to an interface descriptor w/ following properties
  *   - bAlternateSetting of 0 (default)
  *   - bInterfaceClass of 0xFF (Vendor Specific)
  *   - iInterface string descriptor of "JABI USB"
  *   - only 2 bulk transfer endpoints (1 IN, 1 OUT)
  *   - responds to a req_max_size() and resp_max_size() request
+ * Only the descriptors are checked before opening, want_serial/want_path pick
+ * out one device beforehand so others aren't claimed, queried or reset.
  */
-std::vector<Device> USBInterface::list_devices() {
-    if (libusb_init(NULL) < 0) {
-        throw std::runtime_error("libusb failed init");
+std::shared_ptr<USBInterface> USBInterface::open(void *usb_dev, const std::string *want_serial,
+                                                 const std::vector<uint8_t> *want_path) {
+    libusb_device *udev = static_cast<libusb_device*>(usb_dev);
+    struct libusb_device_descriptor dev_desc;
+    if (libusb_get_device_descriptor(udev, &dev_desc) < 0) {
+        return nullptr;
+    }
+    if ((want_serial && dev_desc.iSerialNumber == 0) ||
+        (want_path && usb_port_path(udev) != *want_path)) {
+        return nullptr;
     }
 
-    libusb_device **devs;
-    ssize_t num = libusb_get_device_list(NULL, &devs);
-    if (num < 0) {
-        libusb_exit(NULL);
-        throw std::runtime_error("libusb couldn't get device list");
+    struct libusb_config_descriptor *cfg;
+    if (libusb_get_active_config_descriptor(udev, &cfg) < 0) {
+        return nullptr;
     }
+    const struct libusb_interface_descriptor *if_desc = nullptr;
+    for (auto j = 0; j < cfg->bNumInterfaces && !if_desc; j++) {
+        struct libusb_interface if_descs = cfg->interface[j];
+        if (if_descs.num_altsetting == 0) {
+            continue;
+        }
 
-    std::vector<Device> jabis;
-    for (auto i = 0; i < num; i++) {
-        struct libusb_config_descriptor *cfg;
-        if (libusb_get_active_config_descriptor(devs[i], &cfg) < 0) {
+        const struct libusb_interface_descriptor *d = &if_descs.altsetting[0];
+        if (d->bInterfaceClass != LIBUSB_CLASS_VENDOR_SPEC ||
+            d->iInterface == 0 || d->bNumEndpoints != 2 ||
+            d->bAlternateSetting != 0 ) {
             continue;
         }
 
-        for (auto j = 0; j < cfg->bNumInterfaces; j++) {
-            struct libusb_interface if_descs = cfg->interface[j];
-            if (if_descs.num_altsetting == 0) {
-                continue;
-            }
+        struct libusb_endpoint_descriptor ep0 = d->endpoint[0];
+        struct libusb_endpoint_descriptor ep1 = d->endpoint[1];
+        if ((ep0.bmAttributes & 0x03) != LIBUSB_ENDPOINT_TRANSFER_TYPE_BULK ||
+            (ep1.bmAttributes & 0x03) != LIBUSB_ENDPOINT_TRANSFER_TYPE_BULK ||
+            !((ep0.bEndpointAddress ^ ep1.bEndpointAddress) & 0x80)) {
+            continue;
+        }
+        if_desc = d;
+    }
+    if (!if_desc) {
+        libusb_free_config_descriptor(cfg);
+        return nullptr;
+    }
+    auto ep_out = if_desc->endpoint[0], ep_in = if_desc->endpoint[1];
+    if (ep_out.bEndpointAddress & 0x80) { std::swap(ep_out, ep_in); }
+    int ifnum = if_desc->bInterfaceNumber;
+    int iInterface = if_desc->iInterface;
+    libusb_free_config_descriptor(cfg);
 
-            struct libusb_interface_descriptor if_desc = if_descs.altsetting[0];
-            if (if_desc.bInterfaceClass != LIBUSB_CLASS_VENDOR_SPEC ||
-                if_desc.iInterface == 0 || if_desc.bNumEndpoints != 2 ||
-                if_desc.bAlternateSetting != 0 ) {
-                continue;
-            }
+    // strings need a handle, but reading them doesn't claim anything
+    libusb_device_handle *dev;
+    if (libusb_open(udev, &dev) < 0) {
+        return nullptr;
+    }
+    unsigned char str[256];
+    std::string usb_serial;
+    if (dev_desc.iSerialNumber &&
+            libusb_get_string_descriptor_ascii(dev, dev_desc.iSerialNumber, str, 256) >= 0) {
+        usb_serial = reinterpret_cast<char*>(str);
+    }
+    if ((want_serial && usb_serial != *want_serial) ||
+        libusb_get_string_descriptor_ascii(dev, iInterface, str, 256) < 0 ||
+        std::string(reinterpret_cast<char*>(str)) != "JABI USB" ||
+        libusb_claim_interface(dev, ifnum) < 0) {
+        libusb_close(dev);
+        return nullptr;
+    }
 
-            struct libusb_endpoint_descriptor ep0 = if_desc.endpoint[0];
-            struct libusb_endpoint_descriptor ep1 = if_desc.endpoint[1];
-            if ((ep0.bmAttributes & 0x03) != LIBUSB_ENDPOINT_TRANSFER_TYPE_BULK ||
-                (ep1.bmAttributes & 0x03) != LIBUSB_ENDPOINT_TRANSFER_TYPE_BULK ||
-                !((ep0.bEndpointAddress ^ ep1.bEndpointAddress) & 0x80)) {
-                continue;
-            }
+    std::shared_ptr<USBInterface> iface(
+        new USBInterface(
+            dev,
+            ifnum,
+            ep_out.wMaxPacketSize,
+            ep_out.bEndpointAddress,
+            ep_in.bEndpointAddress
+        )
+    );
+    iface->usb_serial = usb_serial;
+    iface->port_path = usb_port_path(udev);
 
-            libusb_device_handle *dev;
-            if (libusb_open(devs[i], &dev) < 0) {
-                break;
+    Device jabi = Interface::make_device(iface);
+    for (int tries = 0; tries < 2; tries++) {
+        try {
+            if ((iface->req_max_size = jabi.req_max_size()) < REQ_PAYLOAD_MAX_SIZE ||
+                (iface->resp_max_size = jabi.resp_max_size()) < RESP_PAYLOAD_MAX_SIZE) {
+                throw std::runtime_error("maximum packet size too small");
             }
-
-            unsigned char str[256];
-            if (libusb_get_string_descriptor_ascii(dev, if_desc.iInterface, str, 256) < 0) {
-                libusb_close(dev);
+            return iface;
+        } catch(const std::runtime_error&) {
+            // ours now, reset it and try one more time
+            if (tries || libusb_reset_device(dev) < 0) {
                 break;
             }
-            if (std::string(reinterpret_cast<char*>(str)) != "JABI USB") {
-                libusb_close(dev);
-                continue;
-            }
+        }
+    }
+    return nullptr; // closes the handle
+}
 
-            if (libusb_claim_interface(dev, if_desc.bInterfaceNumber) < 0) {
-                libusb_close(dev);
-                continue;
-            }
+std::vector<std::shared_ptr<USBInterface>> USBInterface::open_all() {
+    libusb_device **devs;
+    ssize_t num = libusb_get_device_list(usb_context(), &devs);
+    if (num < 0) {
+        throw LinkError("libusb couldn't get device list");
+    }
 
-            auto ep_out = ep0, ep_in = ep1;
-            if (ep0.bEndpointAddress & 0x80) { std::swap(ep_out, ep_in); }
-
-            std::shared_ptr<USBInterface> iface(
-                new USBInterface(
-                    dev,
-                    if_desc.bInterfaceNumber,
-                    ep_out.wMaxPacketSize,
-                    ep_out.bEndpointAddress,
-                    ep_in.bEndpointAddress
-                )
-            );
-            Device jabi = Interface::make_device(iface);
-            try {
-                if ((iface->req_max_size = jabi.req_max_size()) < REQ_PAYLOAD_MAX_SIZE ||
-                    (iface->resp_max_size = jabi.resp_max_size()) < RESP_PAYLOAD_MAX_SIZE) {
-                    throw std::runtime_error("maximum packet size too small");
-                }
-            } catch(const std::runtime_error&) {
-                // reset device and try one more time
-                if (libusb_reset_device(dev) < 0) {
-                    break;
-                }
-                try {
-                    if ((iface->req_max_size = jabi.req_max_size()) < REQ_PAYLOAD_MAX_SIZE ||
-                        (iface->resp_max_size = jabi.resp_max_size()) < RESP_PAYLOAD_MAX_SIZE) {
-                        throw std::runtime_error("maximum packet size too small");
-                    }
-                } catch(const std::runtime_error&) {
-                    break;
-                }
-            }
-            jabis.push_back(jabi);
+    std::vector<std::shared_ptr<USBInterface>> jabis;
+    for (auto i = 0; i < num; i++) {
+        if (auto iface = open(devs[i], nullptr, nullptr)) {
+            jabis.push_back(iface);
         }
-
-        libusb_free_config_descriptor(cfg);
     }
 
     libusb_free_device_list(devs, 1);
     return jabis;
 }
 
+std::vector<Device> USBInterface::list_devices() {
+    std::vector<Device> jabis;
+    for (auto &iface : open_all()) {
+        jabis.push_back(Interface::make_device(iface));
+    }
+    return jabis;
+}
+
+void USBInterface::reopen() {
+    // the USB serial if it has one, else wherever it was plugged in
+    if (usb_serial.empty() && port_path.empty()) {
+        throw LinkError("USB device identity unknown, can't find it again");
+    }
+    close();
+
+    libusb_device **devs;
+    ssize_t num = libusb_get_device_list(usb_context(), &devs);
+    if (num < 0) {
+        throw LinkError("libusb couldn't get device list");
+    }
+    std::shared_ptr<USBInterface> iface;
+    for (auto i = 0; i < num && !iface; i++) {
+        iface = usb_serial.empty() ? open(devs[i], nullptr, &port_path) : open(devs[i], &usb_serial, nullptr);
+    }
+    libusb_free_device_list(devs, 1);
+    if (!iface) {
+        throw LinkError("USB device " + (usb_serial.empty() ? serial : usb_serial) + " not found");
+    }
+
+    // take over the new handle, old one already closed
+    std::swap(dev, iface->dev);
+    ifnum          = iface->ifnum;
+    wMaxPacketSize = iface->wMaxPacketSize;
+    ep_out         = iface->ep_out;
+    ep_in          = iface->ep_in;
+    req_max_size   = iface->req_max_size;
+    resp_max_size  = iface->resp_max_size;
+}
+
 };
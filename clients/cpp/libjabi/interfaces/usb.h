@@ -9,18 +9,30 @@ class USBInterface : public Interface {
 public:
     ~USBInterface();
 
-    iface_dynamic_resp_t send_request(iface_dynamic_req_t req);
     static std::vector<Device> list_devices();
 
+protected:
+    void send(iface_dynamic_req_t req);
+    iface_dynamic_resp_t recv();
+    void reopen();
+
 private:
     USBInterface(void *dev, int ifnum, int wMaxPacketSize,
         unsigned char ep_out, unsigned char ep_in);
-    
+
+    // usb_dev is a libusb_device*, nullptr if it isn't a JABI or not the one wanted
+    static std::shared_ptr<USBInterface> open(void *usb_dev, const std::string *want_serial,
+                                              const std::vector<uint8_t> *want_path);
+    static std::vector<std::shared_ptr<USBInterface>> open_all();
+    void close();
+
     void *dev; // libusb_device_handle* but libusb.h and pyconfig.h conflict :(
     int ifnum;
     int wMaxPacketSize; // for OUT transfers
     unsigned char ep_out;
     unsigned char ep_in;
+    std::string usb_serial; // iSerialNumber, to find it again w/o opening the others
+    std::vector<uint8_t> port_path; // bus then ports, if it has no serial
 };
 
 };
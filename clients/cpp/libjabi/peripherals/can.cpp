@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <sstream>
 #include <libjabi/byteorder.h>
@@ -8,21 +10,21 @@ namespace jabi {
 #include <jabi/peripherals.h>
 #include <jabi/peripherals/can.h>
 
-#define CAN_MAX_LEN 64
-
 CANMessage::CANMessage()
 :
-    id(0), ext(false), fd(false), brs(false), rtr(false)
+    id(0), ext(false), fd(false), brs(false), rtr(false), timestamp(0), hw_timestamp(0)
 {}
 
 CANMessage::CANMessage(int id, int req_len, bool fd, bool brs)
 :
-    id(id), ext(id & ~0x7FF), fd(fd), brs(brs), rtr(true), data(req_len, 0)
+    id(id), ext(id & ~0x7FF), fd(fd), brs(brs), rtr(true), data(req_len, 0),
+    timestamp(0), hw_timestamp(0)
 {}
 
 CANMessage::CANMessage(int id, std::vector<uint8_t> data, bool fd, bool brs)
 :
-    id(id), ext(id & ~0x7FF), fd(fd), brs(brs), rtr(false), data(data)
+    id(id), ext(id & ~0x7FF), fd(fd), brs(brs), rtr(false), data(data),
+    timestamp(0), hw_timestamp(0)
 {}
 
 std::ostream &operator<<(std::ostream &os, CANMessage const &m) {
@@ -30,6 +32,9 @@ std::ostream &operator<<(std::ostream &os, CANMessage const &m) {
     s << std::hex << std::showbase << "CANMessage(";
     s <<  "id="  << m.id  << ",ext=" << m.ext << ",fd=" << m.fd;
     s << ",brs=" << m.brs << ",rtr=" << m.rtr;
+    if (m.timestamp) {
+        s << std::dec << ",timestamp=" << m.timestamp << std::hex;
+    }
     if (m.rtr) {
         s << ",data.size()=" << m.data.size();
     } else {
@@ -63,6 +68,37 @@ void Device::can_set_filter(int id, int id_mask, int idx) {
     }
 }
 
+size_t Device::can_set_filters(std::vector<CANFilter> filters, int idx) {
+    if (filters.size() > UINT8_MAX) {
+        throw std::runtime_error("too many filters");
+    }
+    size_t len = sizeof(can_set_filters_req_t) + filters.size() * sizeof(can_filter_entry_t);
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_SET_FILTERS_ID,
+            .payload_len = static_cast<uint16_t>(len),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(len, 0),
+    };
+
+    auto args = reinterpret_cast<can_set_filters_req_t*>(req.payload.data());
+    args->num_filters = static_cast<uint8_t>(filters.size());
+    for (size_t i = 0; i < filters.size(); i++) {
+        args->filters[i].id      = htole<uint32_t>(filters[i].id);
+        args->filters[i].id_mask = htole<uint32_t>(filters[i].id_mask);
+        args->filters[i].id_type = filters[i].ext;
+    }
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() != sizeof(can_set_filters_resp_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    return reinterpret_cast<can_set_filters_resp_t*>(resp.payload.data())->num_hw;
+}
+
 void Device::can_set_rate(int bitrate, int bitrate_data, int idx) {
     iface_dynamic_req_t req = {
         .msg = {
@@ -156,10 +192,7 @@ void Device::can_write(CANMessage msg, int idx) {
     args->rtr      = msg.rtr;
     args->data_len = static_cast<uint8_t>(msg.data.size());
     if (!msg.rtr) {
-        req.payload.reserve(req.payload.size() + msg.data.size());
-        for (auto c : msg.data) {
-            req.payload.push_back(c);
-        }
+        req.payload.insert(req.payload.end(), msg.data.begin(), msg.data.end());
         req.msg.payload_len = static_cast<uint16_t>(req.payload.size());
     }
 
@@ -204,11 +237,502 @@ int Device::can_read(CANMessage &msg, int idx) {
     msg.fd   = ret->fd;
     msg.brs  = ret->brs;
     msg.rtr  = ret->rtr;
-    msg.data = std::vector<uint8_t>(ret->data_len, 0);
+    msg.data.resize(ret->data_len);
     if (!ret->rtr) {
         memcpy(msg.data.data(), ret->data, ret->data_len);
     }
     return ret->num_left;
 }
 
+size_t Device::can_read(std::vector<CANMessage> &msgs, size_t max_msgs, int idx) {
+    // reuses msgs' storage, messages are inline so this stays one contiguous buffer
+    msgs.clear();
+    while (msgs.size() < max_msgs) {
+        if (can_read_many(msgs, max_msgs - msgs.size(), idx) <= 0) {
+            break; // skip the round trip for an empty read
+        }
+    }
+    return msgs.size();
+}
+
+int Device::can_read_many(std::vector<CANMessage> &msgs, size_t max_msgs, int idx,
+                          bool timestamps) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = static_cast<uint16_t>(timestamps ? CAN_READ_MANY_TS_ID : CAN_READ_MANY_ID),
+            .payload_len = sizeof(can_read_many_req_t),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(sizeof(can_read_many_req_t), 0),
+    };
+
+    auto args = reinterpret_cast<can_read_many_req_t*>(req.payload.data());
+    args->max_msgs = htole<uint16_t>(static_cast<uint16_t>(std::min<size_t>(max_msgs, UINT16_MAX)));
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() < sizeof(can_read_many_resp_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+
+    auto ret = reinterpret_cast<can_read_many_resp_t*>(resp.payload.data());
+    ret->num_left = letoh<uint16_t>(ret->num_left);
+    ret->num_msgs = letoh<uint16_t>(ret->num_msgs);
+
+    // timestamped records are the same w/ timestamps in front
+    size_t ts_len = timestamps ? sizeof(can_read_many_ts_msg_t) - sizeof(can_read_many_msg_t) : 0;
+    size_t offset = sizeof(can_read_many_resp_t);
+    msgs.reserve(msgs.size() + ret->num_msgs);
+    for (int i = 0; i < ret->num_msgs; i++) {
+        if (offset + ts_len + sizeof(can_read_many_msg_t) > resp.payload.size()) {
+            throw std::runtime_error("unexpected payload length");
+        }
+        auto m = reinterpret_cast<can_read_many_msg_t*>(&resp.payload[offset + ts_len]);
+        size_t data_len = m->rtr ? 0 : m->data_len;
+        if (m->data_len > CAN_MAX_LEN ||
+            offset + ts_len + sizeof(can_read_many_msg_t) + data_len > resp.payload.size()) {
+            throw std::runtime_error("unexpected payload length");
+        }
+
+        // only checked records go in the caller's vector
+        CANMessage &msg = msgs.emplace_back();
+        if (timestamps) {
+            auto t = reinterpret_cast<can_read_many_ts_msg_t*>(&resp.payload[offset]);
+            msg.timestamp    = letoh<uint64_t>(t->timestamp);
+            msg.hw_timestamp = letoh<uint16_t>(t->hw_timestamp);
+        }
+        offset += ts_len;
+        msg.id  = letoh<uint32_t>(m->id);
+        msg.ext = m->id_type;
+        msg.fd  = m->fd;
+        msg.brs = m->brs;
+        msg.rtr = m->rtr;
+        msg.data.resize(m->data_len);
+        if (!m->rtr) {
+            memcpy(msg.data.data(), m->data, data_len);
+        }
+        offset += sizeof(can_read_many_msg_t) + data_len;
+    }
+    if (offset != resp.payload.size()) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    if (ret->num_msgs == 0) {
+        return -1; // empty buffer, no message returned
+    }
+    return ret->num_left;
+}
+
+size_t Device::can_write_many(const std::vector<CANMessage> &msgs, int idx) {
+    size_t queued = 0;
+    while (queued < msgs.size()) {
+        iface_dynamic_req_t req = {
+            .msg = {
+                .periph_id   = PERIPH_CAN_ID,
+                .periph_idx  = static_cast<uint16_t>(idx),
+                .periph_fn   = CAN_WRITE_MANY_ID,
+                .payload_len = 0,
+                .payload     = {0},
+            },
+            .payload = std::vector<uint8_t>(),
+        };
+
+        size_t num = 0; // as many as fit in one request
+        for (size_t i = queued; i < msgs.size(); i++) {
+            const CANMessage &msg = msgs[i];
+            if (msg.data.size() > CAN_MAX_LEN) {
+                throw std::runtime_error("data too long");
+            }
+            size_t len = sizeof(can_write_req_t) + (msg.rtr ? 0 : msg.data.size());
+            if (req.payload.size() + len > interface->get_req_max_size()) {
+                break;
+            }
+            size_t offset = req.payload.size();
+            req.payload.resize(offset + sizeof(can_write_req_t));
+            auto args = reinterpret_cast<can_write_req_t*>(&req.payload[offset]);
+            args->id       = htole<uint32_t>(msg.id);
+            args->id_type  = msg.ext;
+            args->fd       = msg.fd;
+            args->brs      = msg.brs;
+            args->rtr      = msg.rtr;
+            args->data_len = static_cast<uint8_t>(msg.data.size());
+            if (!msg.rtr) {
+                req.payload.insert(req.payload.end(), msg.data.begin(), msg.data.end());
+            }
+            num++;
+        }
+        if (num == 0) {
+            throw std::runtime_error("request too small for a message");
+        }
+        req.msg.payload_len = static_cast<uint16_t>(req.payload.size());
+
+        iface_dynamic_resp_t resp = interface->send_request(req);
+        if (resp.payload.size() != sizeof(can_write_many_resp_t)) {
+            throw std::runtime_error("unexpected payload length");
+        }
+        auto ret = reinterpret_cast<can_write_many_resp_t*>(resp.payload.data());
+        size_t num_queued = letoh<uint16_t>(ret->num_queued);
+        queued += num_queued;
+        if (num_queued < num) {
+            break; // device queue full
+        }
+    }
+    return queued;
+}
+
+CANTxStats Device::can_tx_stats(int idx) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_TX_STATS_ID,
+            .payload_len = 0,
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(),
+    };
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() != sizeof(can_tx_stats_resp_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    auto ret = reinterpret_cast<can_tx_stats_resp_t*>(resp.payload.data());
+
+    CANTxStats stats = {
+        .queued  = letoh<uint32_t>(ret->queued),
+        .sent    = letoh<uint32_t>(ret->sent),
+        .failed  = letoh<uint32_t>(ret->failed),
+        .pending = letoh<uint16_t>(ret->pending),
+    };
+    return stats;
+}
+
+CANBusStats Device::can_bus_stats(bool reset_ids, int idx) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_BUS_STATS_ID,
+            .payload_len = sizeof(can_bus_stats_req_t),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(sizeof(can_bus_stats_req_t), 0),
+    };
+
+    auto args = reinterpret_cast<can_bus_stats_req_t*>(req.payload.data());
+    args->reset_ids = reset_ids;
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() < sizeof(can_bus_stats_resp_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    auto ret = reinterpret_cast<can_bus_stats_resp_t*>(resp.payload.data());
+    if (resp.payload.size() != sizeof(can_bus_stats_resp_t) + ret->num_ids * sizeof(can_bus_stats_id_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+
+    CANBusStats stats = {
+        .rx_frames     = letoh<uint32_t>(ret->rx_frames),
+        .rx_bytes      = letoh<uint32_t>(ret->rx_bytes),
+        .tx_frames     = letoh<uint32_t>(ret->tx_frames),
+        .tx_bytes      = letoh<uint32_t>(ret->tx_bytes),
+        .rx_frame_rate = static_cast<double>(letoh<uint32_t>(ret->rx_frame_rate)),
+        .rx_byte_rate  = static_cast<double>(letoh<uint32_t>(ret->rx_byte_rate)),
+        .tx_frame_rate = static_cast<double>(letoh<uint32_t>(ret->tx_frame_rate)),
+        .tx_byte_rate  = static_cast<double>(letoh<uint32_t>(ret->tx_byte_rate)),
+        .bus_load      = letoh<uint16_t>(ret->bus_load) / 10000.0,
+        .bit0_errors   = letoh<uint32_t>(ret->bit0_errors),
+        .bit1_errors   = letoh<uint32_t>(ret->bit1_errors),
+        .stuff_errors  = letoh<uint32_t>(ret->stuff_errors),
+        .crc_errors    = letoh<uint32_t>(ret->crc_errors),
+        .form_errors   = letoh<uint32_t>(ret->form_errors),
+        .ack_errors    = letoh<uint32_t>(ret->ack_errors),
+        .rx_overruns   = letoh<uint32_t>(ret->rx_overruns),
+        .error_warning = letoh<uint32_t>(ret->error_warning),
+        .error_passive = letoh<uint32_t>(ret->error_passive),
+        .bus_off       = letoh<uint32_t>(ret->bus_off),
+        .filtered      = ret->filtered != 0,
+        .top_ids       = {},
+    };
+    for (int i = 0; i < ret->num_ids; i++) {
+        stats.top_ids.push_back(CANIdCount{
+            .id    = static_cast<int>(letoh<uint32_t>(ret->ids[i].id)),
+            .ext   = ret->ids[i].id_type != 0,
+            .count = letoh<uint32_t>(ret->ids[i].count),
+        });
+    }
+    return stats;
+}
+
+void Device::can_cyclic_set(int slot, CANCyclic entry, int idx) {
+    const CANMessage &msg = entry.msg;
+    if (msg.data.size() > CAN_MAX_LEN) {
+        throw std::runtime_error("data too long");
+    }
+
+    size_t len = sizeof(can_cyclic_set_req_t) + sizeof(can_write_req_t);
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_CYCLIC_SET_ID,
+            .payload_len = static_cast<uint16_t>(len),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(len, 0),
+    };
+
+    auto args = reinterpret_cast<can_cyclic_set_req_t*>(req.payload.data());
+    args->slot          = static_cast<uint8_t>(slot);
+    args->period_us     = htole<uint32_t>(entry.period_us);
+    args->offset_us     = htole<uint32_t>(entry.offset_us);
+    args->counter_byte  = static_cast<uint8_t>(entry.counter_byte);
+    args->counter_bits  = static_cast<uint8_t>(entry.counter_bits);
+    args->checksum_byte = static_cast<uint8_t>(entry.checksum_byte);
+    args->checksum_type = static_cast<uint8_t>(entry.checksum);
+    auto m = reinterpret_cast<can_write_req_t*>(args->msg);
+    m->id       = htole<uint32_t>(msg.id);
+    m->id_type  = msg.ext;
+    m->fd       = msg.fd;
+    m->brs      = msg.brs;
+    m->rtr      = msg.rtr;
+    m->data_len = static_cast<uint8_t>(msg.data.size());
+    if (!msg.rtr) {
+        req.payload.insert(req.payload.end(), msg.data.begin(), msg.data.end());
+        req.msg.payload_len = static_cast<uint16_t>(req.payload.size());
+    }
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() != 0) {
+        throw std::runtime_error("unexpected payload length");
+    }
+}
+
+void Device::can_cyclic_remove(int slot, int idx) {
+    can_cyclic_set(slot, CANCyclic{}, idx); // period of 0
+}
+
+std::vector<CANCyclicStats> Device::can_cyclic_stats(int idx) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_CYCLIC_STATS_ID,
+            .payload_len = 0,
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(),
+    };
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() < sizeof(can_cyclic_stats_resp_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    auto ret = reinterpret_cast<can_cyclic_stats_resp_t*>(resp.payload.data());
+    if (resp.payload.size() != sizeof(can_cyclic_stats_resp_t) + ret->num_entries * sizeof(can_cyclic_entry_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+
+    std::vector<CANCyclicStats> stats;
+    for (int i = 0; i < ret->num_entries; i++) {
+        stats.push_back(CANCyclicStats{
+            .slot      = ret->entries[i].slot,
+            .period_us = static_cast<int>(letoh<uint32_t>(ret->entries[i].period_us)),
+            .sent      = letoh<uint32_t>(ret->entries[i].sent),
+            .missed    = letoh<uint32_t>(ret->entries[i].missed),
+        });
+    }
+    return stats;
+}
+
+void Device::can_route_set(int route, CANRoute cfg, int idx) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_ROUTE_SET_ID,
+            .payload_len = sizeof(can_route_set_req_t),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(sizeof(can_route_set_req_t), 0),
+    };
+
+    auto args = reinterpret_cast<can_route_set_req_t*>(req.payload.data());
+    args->route        = static_cast<uint8_t>(route);
+    args->enable       = 1;
+    args->id           = htole<uint32_t>(cfg.id);
+    args->id_mask      = htole<uint32_t>(cfg.id_mask);
+    args->id_type      = cfg.ext;
+    args->dst          = htole<uint16_t>(static_cast<uint16_t>(cfg.dst));
+    args->rewrite_mask = htole<uint32_t>(cfg.rewrite_mask);
+    args->new_id       = htole<uint32_t>(cfg.new_id);
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() != 0) {
+        throw std::runtime_error("unexpected payload length");
+    }
+}
+
+void Device::can_route_remove(int route, int idx) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_ROUTE_SET_ID,
+            .payload_len = sizeof(can_route_set_req_t),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(sizeof(can_route_set_req_t), 0),
+    };
+
+    auto args = reinterpret_cast<can_route_set_req_t*>(req.payload.data());
+    args->route = static_cast<uint8_t>(route); // enable=0
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() != 0) {
+        throw std::runtime_error("unexpected payload length");
+    }
+}
+
+std::vector<CANRouteStats> Device::can_route_stats(int idx) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_ROUTE_STATS_ID,
+            .payload_len = 0,
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(),
+    };
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() < sizeof(can_route_stats_resp_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    auto ret = reinterpret_cast<can_route_stats_resp_t*>(resp.payload.data());
+    if (resp.payload.size() != sizeof(can_route_stats_resp_t) + ret->num_entries * sizeof(can_route_entry_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+
+    std::vector<CANRouteStats> stats;
+    for (int i = 0; i < ret->num_entries; i++) {
+        stats.push_back(CANRouteStats{
+            .route     = ret->entries[i].route,
+            .dst       = letoh<uint16_t>(ret->entries[i].dst),
+            .forwarded = letoh<uint32_t>(ret->entries[i].forwarded),
+            .dropped   = letoh<uint32_t>(ret->entries[i].dropped),
+        });
+    }
+    return stats;
+}
+
+void Device::isotp_bind(ISOTPConfig cfg, int idx) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_CAN_ID,
+            .periph_idx  = static_cast<uint16_t>(idx),
+            .periph_fn   = CAN_ISOTP_BIND_ID,
+            .payload_len = sizeof(can_isotp_bind_req_t),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(sizeof(can_isotp_bind_req_t), 0),
+    };
+
+    auto args = reinterpret_cast<can_isotp_bind_req_t*>(req.payload.data());
+    args->tx_id       = htole<uint32_t>(cfg.tx_id);
+    args->rx_id       = htole<uint32_t>(cfg.rx_id);
+    args->id_type     = cfg.ext;
+    args->fd          = cfg.fd;
+    args->brs         = cfg.brs;
+    args->tx_dl       = static_cast<uint8_t>(cfg.tx_dl);
+    args->ext_addr    = cfg.ext_addr;
+    args->tx_ext_addr = static_cast<uint8_t>(cfg.tx_ext_addr);
+    args->rx_ext_addr = static_cast<uint8_t>(cfg.rx_ext_addr);
+    args->bs          = static_cast<uint8_t>(cfg.bs);
+    args->stmin       = static_cast<uint8_t>(cfg.stmin);
+
+    if (interface->send_request(req).payload.size() != 0) {
+        throw std::runtime_error("unexpected payload length");
+    }
+}
+
+void Device::isotp_send(std::vector<uint8_t> data, int idx) {
+    if (data.empty() || data.size() > UINT16_MAX) {
+        throw std::runtime_error("invalid PDU length");
+    }
+    size_t chunk = interface->get_req_max_size() - sizeof(can_isotp_send_req_t);
+    size_t offset = 0;
+    bool done = false;
+    while (!done) { // staged in order, last chunk starts it, then empty ones wait
+        size_t len = std::min(chunk, data.size() - offset);
+        iface_dynamic_req_t req = {
+            .msg = {
+                .periph_id   = PERIPH_CAN_ID,
+                .periph_idx  = static_cast<uint16_t>(idx),
+                .periph_fn   = CAN_ISOTP_SEND_ID,
+                .payload_len = static_cast<uint16_t>(sizeof(can_isotp_send_req_t) + len),
+                .payload     = {0},
+            },
+            .payload = std::vector<uint8_t>(sizeof(can_isotp_send_req_t), 0),
+        };
+        auto args = reinterpret_cast<can_isotp_send_req_t*>(req.payload.data());
+        args->total_len = htole<uint16_t>(offset < data.size() ? static_cast<uint16_t>(data.size()) : 0);
+        args->offset    = htole<uint16_t>(static_cast<uint16_t>(offset));
+        req.payload.insert(req.payload.end(), data.begin() + offset, data.begin() + offset + len);
+        offset += len;
+
+        iface_dynamic_resp_t resp = interface->send_request(req);
+        if (resp.payload.size() != sizeof(can_isotp_send_resp_t)) {
+            throw std::runtime_error("unexpected payload length");
+        }
+        done = offset == data.size() && reinterpret_cast<can_isotp_send_resp_t*>(resp.payload.data())->done;
+    }
+}
+
+std::vector<uint8_t> Device::isotp_recv(int timeout_ms, int idx) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::vector<uint8_t> data;
+    size_t total = 0;
+    bool asked = false;
+    while (total == 0 || data.size() < total) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (total == 0 && asked && left <= 0) {
+            return {};
+        }
+        asked = true;
+        iface_dynamic_req_t req = {
+            .msg = {
+                .periph_id   = PERIPH_CAN_ID,
+                .periph_idx  = static_cast<uint16_t>(idx),
+                .periph_fn   = CAN_ISOTP_RECV_ID,
+                .payload_len = sizeof(can_isotp_recv_req_t),
+                .payload     = {0},
+            },
+            .payload = std::vector<uint8_t>(sizeof(can_isotp_recv_req_t), 0),
+        };
+        auto args = reinterpret_cast<can_isotp_recv_req_t*>(req.payload.data());
+        // rest of a PDU is paced by the bus, device gives up on it by itself
+        args->timeout_ms = htole<uint16_t>(static_cast<uint16_t>(
+            total ? UINT16_MAX : std::clamp<long long>(left, 0, UINT16_MAX)));
+
+        iface_dynamic_resp_t resp = interface->send_request(req);
+        if (resp.payload.size() < sizeof(can_isotp_recv_resp_t)) {
+            throw std::runtime_error("unexpected payload length");
+        }
+        auto ret = reinterpret_cast<can_isotp_recv_resp_t*>(resp.payload.data());
+        size_t len = resp.payload.size() - sizeof(can_isotp_recv_resp_t);
+        if (letoh<uint16_t>(ret->total_len) == 0) {
+            continue;
+        }
+        if ((total && letoh<uint16_t>(ret->total_len) != total) || letoh<uint16_t>(ret->offset) != data.size()) {
+            throw std::runtime_error("isotp PDU out of sequence");
+        }
+        total = letoh<uint16_t>(ret->total_len);
+        data.insert(data.end(), ret->data, ret->data + len);
+    }
+    return data;
+}
+
 };
@@ -8,8 +8,6 @@ namespace jabi {
 #include <jabi/peripherals.h>
 #include <jabi/peripherals/lin.h>
 
-#define LIN_MAX_LEN 8
-
 LINMessage::LINMessage()
 :
     id(0), type(LINChecksum::CLASSIC)
@@ -174,9 +172,7 @@ void Device::lin_write(LINMessage msg, int idx) {
     auto args = reinterpret_cast<lin_write_req_t*>(req.payload.data());
     args->id = (uint8_t) msg.id;
     args->checksum_type = static_cast<uint8_t>(msg.type);
-    for (auto c : msg.data) {
-        req.payload.push_back(c);
-    }
+    req.payload.insert(req.payload.end(), msg.data.begin(), msg.data.end());
     req.msg.payload_len = static_cast<uint16_t>(req.payload.size());
 
     iface_dynamic_resp_t resp = interface->send_request(req);
@@ -218,7 +214,7 @@ int Device::lin_read(LINMessage &msg, int id, int idx) {
 
     msg.id   = ret->id;
     msg.type = static_cast<LINChecksum>(ret->checksum_type);
-    msg.data = std::vector<uint8_t>(data_len, 0);
+    msg.data.resize(data_len);
     memcpy(msg.data.data(), ret->data, data_len);
     return ret->num_left;
 }
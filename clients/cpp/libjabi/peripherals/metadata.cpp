@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cstring>
 #include <libjabi/byteorder.h>
 #include <libjabi/interfaces/interface.h>
@@ -121,4 +122,280 @@ std::vector<uint8_t> Device::custom(std::vector<uint8_t> data) {
     return resp.payload;
 }
 
+RXArena Device::rx_arena() {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_METADATA_ID,
+            .periph_idx  = 0,
+            .periph_fn   = METADATA_RX_ARENA_ID,
+            .payload_len = 0,
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(),
+    };
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() < sizeof(metadata_rx_arena_resp_t) ||
+        (resp.payload.size() - sizeof(metadata_rx_arena_resp_t)) % sizeof(metadata_rx_buffer_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    auto ret = reinterpret_cast<metadata_rx_arena_resp_t*>(resp.payload.data());
+    size_t num = (resp.payload.size() - sizeof(metadata_rx_arena_resp_t)) / sizeof(metadata_rx_buffer_t);
+
+    RXArena arena = {
+        .size = letoh<uint32_t>(ret->size),
+        .free = letoh<uint32_t>(ret->free),
+        .buffers = {},
+    };
+    for (size_t i = 0; i < num; i++) {
+        arena.buffers.push_back(RXBuffer{
+            .id   = static_cast<InstID>(letoh<uint16_t>(ret->buffers[i].periph_id)),
+            .idx  = letoh<uint16_t>(ret->buffers[i].periph_idx),
+            .size = letoh<uint32_t>(ret->buffers[i].size),
+        });
+    }
+    return arena;
+}
+
+void Device::set_rx_arena(std::vector<RXBuffer> buffers) {
+    if (buffers.size() * sizeof(metadata_set_rx_arena_req_t) > interface->get_req_max_size()) {
+        throw std::runtime_error("too many buffers");
+    }
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_METADATA_ID,
+            .periph_idx  = 0,
+            .periph_fn   = METADATA_SET_RX_ARENA_ID,
+            .payload_len = static_cast<uint16_t>(buffers.size() * sizeof(metadata_set_rx_arena_req_t)),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(buffers.size() * sizeof(metadata_set_rx_arena_req_t), 0),
+    };
+
+    auto args = reinterpret_cast<metadata_set_rx_arena_req_t*>(req.payload.data());
+    for (size_t i = 0; i < buffers.size(); i++) {
+        args[i].periph_id  = htole<uint16_t>(static_cast<uint16_t>(buffers[i].id));
+        args[i].periph_idx = htole<uint16_t>(static_cast<uint16_t>(buffers[i].idx));
+        args[i].size       = htole<uint32_t>(static_cast<uint32_t>(buffers[i].size));
+    }
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() != 0) {
+        throw std::runtime_error("unexpected payload length");
+    }
+}
+
+PeriphStats Device::periph_stats(InstID id, int idx) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_METADATA_ID,
+            .periph_idx  = 0,
+            .periph_fn   = METADATA_PERIPH_STATS_ID,
+            .payload_len = sizeof(metadata_periph_stats_req_t),
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(sizeof(metadata_periph_stats_req_t), 0),
+    };
+
+    auto args = reinterpret_cast<metadata_periph_stats_req_t*>(req.payload.data());
+    args->periph_id  = htole<uint16_t>(static_cast<uint16_t>(id));
+    args->periph_idx = htole<uint16_t>(static_cast<uint16_t>(idx));
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() < sizeof(metadata_periph_stats_resp_t) ||
+        (resp.payload.size() - sizeof(metadata_periph_stats_resp_t)) % sizeof(metadata_fn_stats_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    auto ret = reinterpret_cast<metadata_periph_stats_resp_t*>(resp.payload.data());
+    size_t num = (resp.payload.size() - sizeof(metadata_periph_stats_resp_t)) / sizeof(metadata_fn_stats_t);
+    double cycles_per_sec = letoh<uint32_t>(ret->cycles_per_sec);
+
+    PeriphStats stats = {
+        .rx         = letoh<uint32_t>(ret->rx),
+        .rx_dropped = letoh<uint32_t>(ret->rx_dropped),
+        .rx_high    = letoh<uint32_t>(ret->rx_high),
+        .busy       = letoh<uint32_t>(ret->busy),
+        .funcs      = {},
+    };
+    for (size_t i = 0; i < num; i++) {
+        stats.funcs.push_back(FuncStats{
+            .calls = letoh<uint32_t>(ret->fns[i].calls),
+            .time  = cycles_per_sec ? letoh<uint64_t>(ret->fns[i].cycles) / cycles_per_sec : 0.0,
+        });
+    }
+    return stats;
+}
+
+std::vector<IfaceStats> Device::iface_stats() {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_METADATA_ID,
+            .periph_idx  = 0,
+            .periph_fn   = METADATA_IFACE_STATS_ID,
+            .payload_len = 0,
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(),
+    };
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() % sizeof(metadata_iface_stats_resp_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    auto ret = reinterpret_cast<metadata_iface_stats_resp_t*>(resp.payload.data());
+
+    std::vector<IfaceStats> stats;
+    for (size_t i = 0; i < resp.payload.size() / sizeof(metadata_iface_stats_resp_t); i++) {
+        stats.push_back(IfaceStats{
+            .rx_bytes = letoh<uint32_t>(ret[i].rx_bytes),
+            .tx_bytes = letoh<uint32_t>(ret[i].tx_bytes),
+            .errors   = letoh<uint32_t>(ret[i].errors),
+        });
+    }
+    return stats;
+}
+
+std::string Device::log_read() {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_METADATA_ID,
+            .periph_idx  = 0,
+            .periph_fn   = METADATA_LOG_READ_ID,
+            .payload_len = 0,
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(),
+    };
+
+    std::string log;
+    while (true) { // short read means drained, don't chase messages logged meanwhile
+        iface_dynamic_resp_t resp = interface->send_request(req);
+        log.append(resp.payload.begin(), resp.payload.end());
+        if (resp.payload.size() < interface->get_resp_max_size()) {
+            return log;
+        }
+    }
+}
+
+void Device::sink(std::vector<uint8_t> data) {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_METADATA_ID,
+            .periph_idx  = 0,
+            .periph_fn   = METADATA_SINK_ID,
+            .payload_len = static_cast<uint16_t>(data.size()),
+            .payload     = {0},
+        },
+        .payload = data,
+    };
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() != 0) {
+        throw std::runtime_error("unexpected payload length");
+    }
+}
+
+std::vector<uint8_t> Device::source() {
+    iface_dynamic_req_t req = {
+        .msg = {
+            .periph_id   = PERIPH_METADATA_ID,
+            .periph_idx  = 0,
+            .periph_fn   = METADATA_SOURCE_ID,
+            .payload_len = 0,
+            .payload     = {0},
+        },
+        .payload = std::vector<uint8_t>(),
+    };
+
+    iface_dynamic_resp_t resp = interface->send_request(req);
+    if (resp.payload.size() < sizeof(metadata_source_resp_t)) {
+        throw std::runtime_error("unexpected payload length");
+    }
+    return resp.payload;
+}
+
+LinkStats Device::link_test(size_t count) {
+    LinkStats stats = {};
+    stats.count = count;
+    if (count == 0) {
+        return stats;
+    }
+
+    std::vector<uint8_t> data(interface->get_req_max_size());
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        sink(data);
+    }
+    double tx_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t rx_bytes = 0;
+    uint32_t last_seq = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        std::vector<uint8_t> payload = source();
+        rx_bytes += payload.size();
+
+        auto ret = reinterpret_cast<metadata_source_resp_t*>(payload.data());
+        uint32_t seq = letoh<uint32_t>(ret->seq);
+        bool ok = i == 0 || seq == last_seq + 1; // counter is shared, run alone
+        size_t len = payload.size() - sizeof(metadata_source_resp_t);
+        for (size_t j = 0; j < len && ok; j++) {
+            ok = ret->data[j] == static_cast<uint8_t>(seq + j);
+        }
+        stats.errors += !ok;
+        last_seq = seq;
+    }
+    double rx_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    stats.tx_rate = data.size() * count / tx_time;
+    stats.rx_rate = rx_bytes / rx_time;
+    stats.tx_latency = tx_time / count;
+    stats.rx_latency = rx_time / count;
+    return stats;
+}
+
+void Device::set_auto_reconnect(bool enable) {
+    interface->set_reconnect(enable, enable ? serial() : "");
+}
+
+void Device::reconnect() {
+    interface->reconnect();
+}
+
+void Device::set_skip_redundant(bool enable) {
+    interface->set_skip_redundant(enable);
+}
+
+void Device::invalidate_shadow() {
+    interface->invalidate_shadow();
+}
+
+void Device::invalidate_shadow(InstID id, int idx) {
+    interface->invalidate_shadow(static_cast<int>(id), idx);
+}
+
+void Device::set_coalesce_reads(bool enable, double max_age) {
+    interface->set_coalesce_reads(enable, std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(max_age)));
+}
+
+void Device::set_combine_writes(bool enable) {
+    interface->set_combine_writes(enable);
+}
+
+void Device::flush_writes() {
+    interface->flush_writes();
+}
+
+OutputStats Device::write_stats(InstID id, int idx) {
+    return interface->write_stats(static_cast<int>(id), idx);
+}
+
+void Device::set_tagged(bool enable) {
+    interface->set_tagged(enable);
+}
+
 };
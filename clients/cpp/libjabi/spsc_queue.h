@@ -0,0 +1,62 @@
+#ifndef LIBJABI_SPSC_QUEUE_H
+#define LIBJABI_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace jabi {
+
+/* Lock-free ring for exactly one producer and one consumer thread. Capacity
+ * is rounded up to a power of two, push fails instead of overwriting.
+ */
+template<typename T>
+class SPSCQueue {
+public:
+    explicit SPSCQueue(size_t capacity) : buf(round_up(capacity)), mask(buf.size() - 1) {}
+
+    bool push(const T &val) { // producer only
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == buf.size()) {
+            return false;
+        }
+        buf[t & mask] = val;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> pop() { // consumer only
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        T val = std::move(buf[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return val;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return buf.size(); }
+    bool empty() const { return size() == 0; }
+
+private:
+    static size_t round_up(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    std::vector<T> buf;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0}; // written by consumer
+    alignas(64) std::atomic<size_t> tail{0}; // written by producer
+};
+
+};
+
+#endif // LIBJABI_SPSC_QUEUE_H
@@ -0,0 +1,79 @@
+#ifndef LIBJABI_STATIC_VECTOR_H
+#define LIBJABI_STATIC_VECTOR_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace jabi {
+
+/* Fixed capacity vector w/ inline storage, used for frame payloads so that
+ * messages don't heap allocate and arrays of them stay contiguous.
+ */
+template<typename T, size_t N>
+class StaticVector {
+public:
+    StaticVector() : buf{}, len(0) {}
+    explicit StaticVector(size_t n, T val=T()) : buf{}, len(0) { resize(n, val); }
+    StaticVector(std::initializer_list<T> l) : StaticVector(l.begin(), l.end()) {}
+    StaticVector(const std::vector<T> &v) : StaticVector(v.begin(), v.end()) {}
+
+    template<typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    StaticVector(It first, It last) : buf{}, len(0) { assign(first, last); }
+
+    template<typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    void assign(It first, It last) {
+        clear();
+        for (; first != last; first++) { push_back(*first); }
+    }
+
+    void push_back(T val) {
+        if (len >= N) {
+            throw std::runtime_error("data too long");
+        }
+        buf[len++] = val;
+    }
+
+    void resize(size_t n, T val=T()) {
+        if (n > N) {
+            throw std::runtime_error("data too long");
+        }
+        if (n > len) {
+            std::fill(buf.begin() + len, buf.begin() + n, val);
+        }
+        len = n;
+    }
+
+    void clear() { len = 0; }
+
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    static constexpr size_t capacity() { return N; }
+
+    T *data() { return buf.data(); }
+    const T *data() const { return buf.data(); }
+    T *begin() { return buf.data(); }
+    T *end() { return buf.data() + len; }
+    const T *begin() const { return buf.data(); }
+    const T *end() const { return buf.data() + len; }
+    T &operator[](size_t i) { return buf[i]; }
+    const T &operator[](size_t i) const { return buf[i]; }
+
+    operator std::vector<T>() const { return std::vector<T>(begin(), end()); }
+
+    bool operator==(const StaticVector &o) const {
+        return std::equal(begin(), end(), o.begin(), o.end());
+    }
+
+private:
+    std::array<T, N> buf;
+    size_t len;
+};
+
+};
+
+#endif // LIBJABI_STATIC_VECTOR_H
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <gtest/gtest.h>
+#include "fake_interface.h"
+
+namespace jabi {
+
+#include <jabi/error.h>
+#include <jabi/peripherals.h>
+#include <jabi/peripherals/adc.h>
+#include <jabi/peripherals/gpio.h>
+
+static iface_dynamic_resp_t respond(const iface_dynamic_req_t &req) {
+    if (req.msg.periph_id == PERIPH_GPIO_ID && req.msg.periph_fn == GPIO_READ_ID) {
+        return FakeInterface::ok({1});
+    }
+    if (req.msg.periph_id == PERIPH_ADC_ID && req.msg.periph_fn == ADC_READ_ID) {
+        int32_t mv = htole<int32_t>(1234);
+        std::vector<uint8_t> payload(sizeof(mv));
+        std::memcpy(payload.data(), &mv, sizeof(mv));
+        return FakeInterface::ok(payload);
+    }
+    return FakeInterface::ok();
+}
+
+class CoalesceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fake->set_respond(respond);
+        dev.set_coalesce_reads(true, 10.0);
+    }
+
+    std::shared_ptr<FakeInterface> fake = FakeInterface::make();
+    Device dev = FakeInterface::device(fake);
+};
+
+TEST_F(CoalesceTest, ConcurrentReadsShareOneRequest) {
+    fake->hold(); // others arrive while the first is in flight
+    std::vector<std::thread> threads;
+    std::atomic<int> num_high{0};
+    threads.emplace_back([&]() { num_high += dev.gpio_read(1); });
+    fake->wait_held();
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&]() { num_high += dev.gpio_read(1); });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    fake->release();
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(num_high, 5);
+    EXPECT_EQ(fake->count(PERIPH_GPIO_ID, GPIO_READ_ID), 1);
+}
+
+TEST_F(CoalesceTest, FreshResultIsReused) {
+    EXPECT_EQ(dev.adc_read(0), 1234);
+    EXPECT_EQ(dev.adc_read(0), 1234);
+    EXPECT_EQ(dev.adc_read(1), 1234); // other channel
+    EXPECT_EQ(fake->count(PERIPH_ADC_ID, ADC_READ_ID), 2);
+}
+
+TEST_F(CoalesceTest, ZeroMaxAgeOnlySharesInFlight) {
+    dev.set_coalesce_reads(true, 0.0);
+    dev.gpio_read(1);
+    dev.gpio_read(1);
+    EXPECT_EQ(fake->count(PERIPH_GPIO_ID, GPIO_READ_ID), 2);
+}
+
+TEST_F(CoalesceTest, OffSendsEveryRead) {
+    dev.set_coalesce_reads(false, 10.0);
+    dev.adc_read(0);
+    dev.adc_read(0);
+    EXPECT_EQ(fake->count(PERIPH_ADC_ID, ADC_READ_ID), 2);
+}
+
+TEST_F(CoalesceTest, WriteOnPinInvalidates) {
+    dev.gpio_read(1);
+    dev.gpio_write(1, false);
+    dev.gpio_read(1);
+    dev.gpio_write(2, false); // other pin
+    dev.gpio_read(1);
+    EXPECT_EQ(fake->count(PERIPH_GPIO_ID, GPIO_READ_ID), 2);
+}
+
+TEST_F(CoalesceTest, WriteDuringReadInvalidatesIt) {
+    fake->hold();
+    std::thread reader([&]() { dev.gpio_read(1); });
+    fake->wait_held();
+    std::thread writer([&]() { dev.gpio_write(1, false); }); // waits behind the read
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    fake->release();
+    reader.join();
+    writer.join();
+
+    dev.gpio_read(1); // in flight result predates the write
+    EXPECT_EQ(fake->count(PERIPH_GPIO_ID, GPIO_READ_ID), 2);
+}
+
+TEST_F(CoalesceTest, FailureIsNotCached) {
+    fake->set_respond([](const iface_dynamic_req_t&) { return FakeInterface::error(JABI_PERIPHERAL_ERR); });
+    EXPECT_THROW(dev.adc_read(0), std::runtime_error);
+    fake->set_respond(respond);
+    EXPECT_EQ(dev.adc_read(0), 1234);
+    EXPECT_EQ(fake->count(PERIPH_ADC_ID, ADC_READ_ID), 2);
+}
+
+};
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "fake_interface.h"
+
+namespace jabi {
+
+#include <jabi/error.h>
+#include <jabi/peripherals.h>
+#include <jabi/peripherals/dac.h>
+#include <jabi/peripherals/gpio.h>
+#include <jabi/peripherals/pwm.h>
+
+static iface_dynamic_resp_t respond(const iface_dynamic_req_t &req) {
+    if (req.msg.periph_id == PERIPH_GPIO_ID && req.msg.periph_fn == GPIO_READ_ID) {
+        return FakeInterface::ok({0});
+    }
+    return FakeInterface::ok();
+}
+
+static int32_t dac_mv(const iface_dynamic_req_t &req) {
+    return letoh<int32_t>(reinterpret_cast<const dac_write_req_t*>(req.payload.data())->mv);
+}
+
+class CombineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fake->set_respond(respond);
+        dev.set_combine_writes(true);
+    }
+
+    // a read holds the link until release(), writes meanwhile wait for it
+    void busy() {
+        fake->hold();
+        reader = std::thread([&]() { dev.gpio_read(7); });
+        fake->wait_held();
+    }
+
+    void idle() {
+        fake->release();
+        reader.join(); // flushed as it let go of the link
+    }
+
+    std::vector<iface_dynamic_req_t> writes() {
+        std::vector<iface_dynamic_req_t> w;
+        for (auto &r : fake->requests()) {
+            if (r.msg.periph_fn != GPIO_READ_ID || r.msg.periph_id != PERIPH_GPIO_ID) {
+                w.push_back(r);
+            }
+        }
+        return w;
+    }
+
+    std::shared_ptr<FakeInterface> fake = FakeInterface::make();
+    Device dev = FakeInterface::device(fake);
+    std::thread reader;
+};
+
+TEST_F(CombineTest, IdleLinkSendsEachWrite) {
+    dev.dac_write(0, 100);
+    dev.dac_write(0, 200);
+    EXPECT_EQ(writes().size(), 2);
+
+    OutputStats stats = dev.write_stats(InstID::DAC, 0);
+    EXPECT_EQ(stats.sent, 2);
+    EXPECT_EQ(stats.dropped, 0);
+}
+
+TEST_F(CombineTest, BusyLinkSendsLatestOnly) {
+    busy();
+    dev.dac_write(0, 100);
+    dev.dac_write(0, 200);
+    dev.dac_write(0, 300);
+    EXPECT_TRUE(writes().empty()); // didn't wait on the link
+    idle();
+
+    auto w = writes();
+    ASSERT_EQ(w.size(), 1);
+    EXPECT_EQ(dac_mv(w[0]), 300);
+
+    OutputStats stats = dev.write_stats(InstID::DAC, 0);
+    EXPECT_EQ(stats.sent, 1);
+    EXPECT_EQ(stats.dropped, 2);
+    EXPECT_GT(stats.max_latency, 0.0);
+}
+
+TEST_F(CombineTest, EachOutputHasItsOwnSlot) {
+    busy();
+    dev.dac_write(0, 100);
+    dev.dac_write(1, 200);
+    dev.pwm_write(0, 0.001, 0.002);
+    dev.gpio_write(3, true);
+    dev.dac_write(0, 300);
+    idle();
+
+    EXPECT_EQ(writes().size(), 4);
+    EXPECT_EQ(dev.write_stats(InstID::DAC, 0).dropped, 1);
+    EXPECT_EQ(dev.write_stats(InstID::DAC, 1).dropped, 0);
+}
+
+TEST_F(CombineTest, FlushRethrowsFailedWrite) {
+    fake->set_respond([](const iface_dynamic_req_t&) { return FakeInterface::error(JABI_PERIPHERAL_ERR); });
+    EXPECT_NO_THROW(dev.dac_write(0, 100));
+    EXPECT_THROW(dev.flush_writes(), std::runtime_error);
+    EXPECT_NO_THROW(dev.flush_writes()); // reported once
+    EXPECT_EQ(dev.write_stats(InstID::DAC, 0).sent, 0);
+}
+
+TEST_F(CombineTest, NextUpdateRethrowsFailedWrite) {
+    fake->set_respond([](const iface_dynamic_req_t&) { return FakeInterface::error(JABI_PERIPHERAL_ERR); });
+    dev.pwm_write(0, 0.001, 0.002);
+    fake->set_respond(respond);
+    EXPECT_THROW(dev.pwm_write(0, 0.001, 0.002), std::runtime_error);
+    EXPECT_EQ(dev.write_stats(InstID::PWM, 0).sent, 1); // the update itself still went out
+}
+
+TEST_F(CombineTest, DisablingSendsPending) {
+    busy();
+    dev.dac_write(0, 100);
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        fake->release();
+    });
+    dev.set_combine_writes(false); // waits for the link
+    releaser.join();
+    reader.join();
+    EXPECT_EQ(writes().size(), 1);
+
+    dev.dac_write(0, 200);
+    EXPECT_EQ(writes().size(), 2);
+    EXPECT_EQ(dev.write_stats(InstID::DAC, 0).sent, 1); // only combined writes are counted
+}
+
+};
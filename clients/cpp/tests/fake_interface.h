@@ -0,0 +1,183 @@
+#ifndef LIBJABI_TESTS_FAKE_INTERFACE_H
+#define LIBJABI_TESTS_FAKE_INTERFACE_H
+
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <libjabi/interfaces/interface.h>
+
+namespace jabi {
+
+/* Stands in for a device on the other end of the link. respond() answers each
+ * request, tagged ones get their tag back after delay() so they can finish
+ * out of order like on a device w/ workers
+ */
+class FakeInterface : public Interface {
+public:
+    using respond_fn = std::function<iface_dynamic_resp_t(const iface_dynamic_req_t&)>;
+    using delay_fn = std::function<std::chrono::milliseconds(const iface_dynamic_req_t&)>;
+
+    static std::shared_ptr<FakeInterface> make() { return std::shared_ptr<FakeInterface>(new FakeInterface()); }
+    static Device device(std::shared_ptr<FakeInterface> f) { return make_device(f); }
+
+    static iface_dynamic_resp_t ok(std::vector<uint8_t> payload={}) {
+        iface_dynamic_resp_t resp{};
+        resp.payload = payload;
+        resp.msg.payload_len = static_cast<uint16_t>(payload.size());
+        return resp;
+    }
+
+    static iface_dynamic_resp_t error(int16_t retcode) {
+        iface_dynamic_resp_t resp{};
+        resp.msg.retcode = retcode;
+        return resp;
+    }
+
+    // requests as the device saw them, tags stripped
+    std::vector<iface_dynamic_req_t> requests() {
+        std::scoped_lock lk(m);
+        return sent;
+    }
+
+    size_t count(uint16_t periph_id, uint16_t periph_fn) {
+        size_t num = 0;
+        for (auto &r : requests()) {
+            num += r.msg.periph_id == periph_id && r.msg.periph_fn == periph_fn;
+        }
+        return num;
+    }
+
+    void clear() {
+        std::scoped_lock lk(m);
+        sent.clear();
+    }
+
+    void set_respond(respond_fn fn) {
+        std::scoped_lock lk(m);
+        respond = fn;
+    }
+
+    void set_delay(delay_fn fn) {
+        std::scoped_lock lk(m);
+        delay = fn;
+    }
+
+    // the next request is held before it's answered until release(), keeping the link busy
+    void hold() {
+        std::scoped_lock lk(m);
+        hold_next = true;
+    }
+
+    void wait_held() {
+        std::unique_lock lk(m);
+        cv.wait(lk, [&]() { return held; });
+    }
+
+    void release() {
+        std::scoped_lock lk(m);
+        held = false;
+        cv.notify_all();
+    }
+
+    void set_link_down(bool down) {
+        std::scoped_lock lk(m);
+        link_down = down;
+        cv.notify_all(); // a waiting recv fails now
+    }
+
+    int num_reopens() {
+        std::scoped_lock lk(m);
+        return reopens;
+    }
+
+    size_t max_outstanding() {
+        std::scoped_lock lk(m);
+        return max_pending;
+    }
+
+protected:
+    void send(iface_dynamic_req_t req) override {
+        std::unique_lock lk(m);
+        if (link_down) {
+            throw LinkError("fake link down");
+        }
+        bool tagged = req.msg.periph_fn & IFACE_FN_TAGGED;
+        std::vector<uint8_t> tag;
+        if (tagged) {
+            req.msg.periph_fn &= ~IFACE_FN_TAGGED;
+            tag.assign(req.payload.end() - IFACE_TAG_SIZE, req.payload.end());
+            req.payload.resize(req.payload.size() - IFACE_TAG_SIZE);
+            req.msg.payload_len = static_cast<uint16_t>(req.payload.size());
+        }
+        sent.push_back(req);
+        if (hold_next) {
+            hold_next = false;
+            held = true;
+            cv.notify_all();
+            cv.wait(lk, [&]() { return !held; });
+        }
+
+        iface_dynamic_resp_t resp = respond ? respond(req) : ok();
+        auto ready = std::chrono::steady_clock::now() + (tagged && delay ? delay(req) : std::chrono::milliseconds(0));
+        if (tagged) {
+            resp.payload.insert(resp.payload.end(), tag.begin(), tag.end());
+            resp.msg.payload_len = static_cast<uint16_t>(resp.payload.size());
+        } else if (!pending.empty()) {
+            ready = std::max(ready, pending.back().first); // untagged answered in order
+        }
+        pending.emplace_back(ready, resp);
+        max_pending = std::max(max_pending, pending.size());
+        cv.notify_all();
+    }
+
+    iface_dynamic_resp_t recv() override {
+        std::unique_lock lk(m);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (true) {
+            if (link_down) {
+                throw LinkError("fake link down");
+            }
+            auto next = std::min_element(pending.begin(), pending.end(),
+                [](auto &a, auto &b) { return a.first < b.first; });
+            auto now = std::chrono::steady_clock::now();
+            if (next != pending.end() && next->first <= now) {
+                iface_dynamic_resp_t resp = next->second;
+                pending.erase(next);
+                return resp;
+            }
+            if (now >= deadline) {
+                throw LinkError("fake recv timeout");
+            }
+            cv.wait_until(lk, next != pending.end() ? std::min(next->first, deadline) : deadline);
+        }
+    }
+
+    void reopen() override {
+        std::scoped_lock lk(m);
+        if (link_down) {
+            throw LinkError("fake device gone");
+        }
+        pending.clear();
+        reopens++;
+    }
+
+private:
+    FakeInterface() = default;
+
+    std::mutex m;
+    std::condition_variable cv;
+    respond_fn respond;
+    delay_fn delay;
+    bool hold_next = false;
+    bool held = false;
+    bool link_down = false;
+    int reopens = 0;
+    std::vector<iface_dynamic_req_t> sent;
+    std::deque<std::pair<std::chrono::steady_clock::time_point, iface_dynamic_resp_t>> pending;
+    size_t max_pending = 0;
+};
+
+};
+
+#endif // LIBJABI_TESTS_FAKE_INTERFACE_H
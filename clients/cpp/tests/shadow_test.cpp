@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "fake_interface.h"
+
+namespace jabi {
+
+#include <jabi/error.h>
+#include <jabi/peripherals.h>
+#include <jabi/peripherals/can.h>
+#include <jabi/peripherals/gpio.h>
+#include <jabi/peripherals/i2c.h>
+#include <jabi/peripherals/metadata.h>
+#include <jabi/peripherals/pwm.h>
+#include <jabi/peripherals/uart.h>
+
+// set_filters answers w/ how many went into hardware, the serial for auto reconnect
+static iface_dynamic_resp_t respond(const iface_dynamic_req_t &req) {
+    if (req.msg.periph_id == PERIPH_CAN_ID && req.msg.periph_fn == CAN_SET_FILTERS_ID) {
+        return FakeInterface::ok({1});
+    }
+    if (req.msg.periph_id == PERIPH_METADATA_ID && req.msg.periph_fn == METADATA_SERIAL_ID) {
+        return FakeInterface::ok({'f', 'a', 'k', 'e'});
+    }
+    return FakeInterface::ok();
+}
+
+class ShadowTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fake->set_respond(respond);
+    }
+
+    std::shared_ptr<FakeInterface> fake = FakeInterface::make();
+    Device dev = FakeInterface::device(fake);
+};
+
+TEST_F(ShadowTest, ReplaysLatestConfigInOrderApplied) {
+    dev.can_set_rate(500000, 2000000);
+    dev.uart_set_config(9600);
+    dev.can_set_rate(250000, 1000000); // replaces the first, now applied after uart
+    fake->clear();
+
+    dev.reconnect();
+
+    auto reqs = fake->requests();
+    ASSERT_EQ(reqs.size(), 2);
+    EXPECT_EQ(reqs[0].msg.periph_id, PERIPH_UART_ID);
+    EXPECT_EQ(reqs[1].msg.periph_id, PERIPH_CAN_ID);
+    auto rate = reinterpret_cast<can_set_rate_req_t*>(reqs[1].payload.data());
+    EXPECT_EQ(letoh<uint32_t>(rate->bitrate), 250000);
+    EXPECT_EQ(fake->num_reopens(), 1);
+}
+
+TEST_F(ShadowTest, OutputsAreNotReplayed) {
+    dev.pwm_write(0, 0.001, 0.002);
+    dev.dac_write(0, 1000);
+    dev.gpio_write(1, true);
+    fake->clear();
+
+    dev.reconnect();
+
+    EXPECT_TRUE(fake->requests().empty());
+}
+
+TEST_F(ShadowTest, GpioModeReplaysLastWrittenValue) {
+    dev.gpio_set_mode(3, GPIODir::OUTPUT, GPIOPull::NONE, true);
+    dev.gpio_write(3, false);
+    fake->clear();
+
+    dev.reconnect();
+
+    auto reqs = fake->requests();
+    ASSERT_EQ(reqs.size(), 1);
+    EXPECT_EQ(reqs[0].msg.periph_fn, GPIO_SET_MODE_ID);
+    EXPECT_EQ(reinterpret_cast<gpio_set_mode_req_t*>(reqs[0].payload.data())->init_val, 0);
+}
+
+TEST_F(ShadowTest, CanFilterFunctionsReplaceEachOther) {
+    dev.can_set_filter(0x100, 0x7FF);
+    dev.can_set_filters({{0x200, 0x7FF, false}, {0x300, 0x7FF, false}});
+    fake->clear();
+
+    dev.reconnect();
+
+    auto reqs = fake->requests();
+    ASSERT_EQ(reqs.size(), 1);
+    EXPECT_EQ(reqs[0].msg.periph_fn, CAN_SET_FILTERS_ID);
+}
+
+TEST_F(ShadowTest, ReplayIsPipelinedAndDropsRejected) {
+    dev.can_set_rate(500000, 2000000);
+    dev.i2c_set_freq(I2CFreq::FAST);
+    dev.uart_set_config(9600);
+    fake->set_respond([](const iface_dynamic_req_t &req) {
+        return req.msg.periph_id == PERIPH_I2C_ID ? FakeInterface::error(JABI_PERIPHERAL_ERR) : respond(req);
+    });
+    fake->clear();
+
+    dev.reconnect();
+    EXPECT_EQ(fake->requests().size(), 3);
+    EXPECT_EQ(fake->max_outstanding(), 2); // sent ahead of the responses
+
+    fake->clear();
+    dev.reconnect();
+    EXPECT_EQ(fake->count(PERIPH_I2C_ID, I2C_SET_FREQ_ID), 0);
+    EXPECT_EQ(fake->requests().size(), 2);
+}
+
+TEST_F(ShadowTest, InvalidateForgetsOneInstance) {
+    dev.can_set_rate(500000, 2000000);
+    dev.uart_set_config(9600);
+    dev.invalidate_shadow(InstID::CAN, 0);
+    fake->clear();
+
+    dev.reconnect();
+
+    auto reqs = fake->requests();
+    ASSERT_EQ(reqs.size(), 1);
+    EXPECT_EQ(reqs[0].msg.periph_id, PERIPH_UART_ID);
+}
+
+TEST_F(ShadowTest, AutoReconnectReplaysBeforeRetrying) {
+    dev.set_auto_reconnect(true);
+    dev.uart_set_config(9600);
+    fake->set_link_down(true);
+    fake->clear();
+    std::thread replug([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        fake->set_link_down(false);
+    });
+
+    dev.can_set_rate(250000, 1000000);
+    replug.join();
+
+    auto reqs = fake->requests();
+    ASSERT_EQ(reqs.size(), 2);
+    EXPECT_EQ(reqs[0].msg.periph_id, PERIPH_UART_ID);
+    EXPECT_EQ(reqs[1].msg.periph_id, PERIPH_CAN_ID);
+}
+
+};
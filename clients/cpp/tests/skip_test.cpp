@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "fake_interface.h"
+
+namespace jabi {
+
+#include <jabi/error.h>
+#include <jabi/peripherals.h>
+#include <jabi/peripherals/can.h>
+#include <jabi/peripherals/gpio.h>
+#include <jabi/peripherals/spi.h>
+#include <jabi/peripherals/uart.h>
+
+static iface_dynamic_resp_t respond(const iface_dynamic_req_t &req) {
+    if (req.msg.periph_id == PERIPH_CAN_ID && req.msg.periph_fn == CAN_SET_FILTERS_ID) {
+        return FakeInterface::ok({1});
+    }
+    return FakeInterface::ok();
+}
+
+class SkipTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fake->set_respond(respond);
+        dev.set_skip_redundant(true);
+    }
+
+    std::shared_ptr<FakeInterface> fake = FakeInterface::make();
+    Device dev = FakeInterface::device(fake);
+};
+
+TEST_F(SkipTest, IdenticalSettingIsSkipped) {
+    dev.uart_set_config(9600);
+    dev.uart_set_config(9600);
+    EXPECT_EQ(fake->count(PERIPH_UART_ID, UART_SET_CONFIG_ID), 1);
+
+    dev.uart_set_config(115200);
+    dev.uart_set_config(9600); // same as two ago, not as the last applied
+    EXPECT_EQ(fake->count(PERIPH_UART_ID, UART_SET_CONFIG_ID), 3);
+}
+
+TEST_F(SkipTest, OffByDefault) {
+    dev.set_skip_redundant(false);
+    dev.spi_set_freq(1000000);
+    dev.spi_set_freq(1000000);
+    EXPECT_EQ(fake->count(PERIPH_SPI_ID, SPI_SET_FREQ_ID), 2);
+}
+
+TEST_F(SkipTest, OtherInstanceIsSent) {
+    dev.spi_set_freq(1000000, 0);
+    dev.spi_set_freq(1000000, 1);
+    EXPECT_EQ(fake->count(PERIPH_SPI_ID, SPI_SET_FREQ_ID), 2);
+}
+
+TEST_F(SkipTest, SetFiltersIsNeverSkipped) {
+    std::vector<CANFilter> filters{{0x100, 0x7FF, false}};
+    EXPECT_EQ(dev.can_set_filters(filters), 1);
+    EXPECT_EQ(dev.can_set_filters(filters), 1); // answer comes from the device
+    EXPECT_EQ(fake->count(PERIPH_CAN_ID, CAN_SET_FILTERS_ID), 2);
+}
+
+TEST_F(SkipTest, GpioModeIsNeverSkipped) {
+    dev.gpio_set_mode(2, GPIODir::OUTPUT, GPIOPull::NONE, true);
+    dev.gpio_write(2, false);
+    dev.gpio_set_mode(2, GPIODir::OUTPUT, GPIOPull::NONE, true); // drives the pin high again
+    EXPECT_EQ(fake->count(PERIPH_GPIO_ID, GPIO_SET_MODE_ID), 2);
+}
+
+TEST_F(SkipTest, RejectedSettingIsResent) {
+    fake->set_respond([](const iface_dynamic_req_t&) { return FakeInterface::error(JABI_PERIPHERAL_ERR); });
+    EXPECT_THROW(dev.uart_set_config(9600), std::runtime_error);
+    fake->set_respond(respond);
+    dev.uart_set_config(9600);
+    EXPECT_EQ(fake->count(PERIPH_UART_ID, UART_SET_CONFIG_ID), 2);
+}
+
+TEST_F(SkipTest, InvalidatedSettingIsResent) {
+    dev.uart_set_config(9600);
+    dev.invalidate_shadow(InstID::UART);
+    dev.uart_set_config(9600);
+    EXPECT_EQ(fake->count(PERIPH_UART_ID, UART_SET_CONFIG_ID), 2);
+}
+
+};
@@ -0,0 +1,117 @@
+#include <atomic>
+#include <gtest/gtest.h>
+#include "fake_interface.h"
+
+namespace jabi {
+
+#include <jabi/error.h>
+#include <jabi/peripherals.h>
+#include <jabi/peripherals/adc.h>
+#include <jabi/peripherals/uart.h>
+
+// each channel reads its own index in mV
+static iface_dynamic_resp_t respond(const iface_dynamic_req_t &req) {
+    if (req.msg.periph_id == PERIPH_ADC_ID && req.msg.periph_fn == ADC_READ_ID) {
+        int32_t mv = htole<int32_t>(req.msg.periph_idx);
+        std::vector<uint8_t> payload(sizeof(mv));
+        std::memcpy(payload.data(), &mv, sizeof(mv));
+        return FakeInterface::ok(payload);
+    }
+    return FakeInterface::ok();
+}
+
+class TaggedTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fake->set_respond(respond);
+        dev.set_tagged(true);
+    }
+
+    void wait_sent(size_t num) {
+        while (fake->requests().size() < num) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::shared_ptr<FakeInterface> fake = FakeInterface::make();
+    Device dev = FakeInterface::device(fake);
+};
+
+TEST_F(TaggedTest, SlowRequestDoesNotBlockOthers) {
+    fake->set_delay([](const iface_dynamic_req_t &req) {
+        bool slow = req.msg.periph_id == PERIPH_ADC_ID && req.msg.periph_idx == 0;
+        return std::chrono::milliseconds(slow ? 500 : 0);
+    });
+    std::atomic<bool> slow_done{false};
+    std::thread slow([&]() {
+        EXPECT_EQ(dev.adc_read(0), 0);
+        slow_done = true;
+    });
+    wait_sent(1);
+
+    EXPECT_EQ(dev.adc_read(1), 1);
+    dev.uart_set_config(9600);
+    EXPECT_FALSE(slow_done);
+    slow.join();
+}
+
+TEST_F(TaggedTest, ResponsesAreRoutedByTag) {
+    fake->set_delay([](const iface_dynamic_req_t &req) {
+        return std::chrono::milliseconds(100 - 10 * req.msg.periph_idx); // answered in reverse
+    });
+    std::vector<std::thread> threads;
+    std::atomic<int> num_ok{0};
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&, i]() { num_ok += dev.adc_read(i) == i; });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(num_ok, 8);
+    EXPECT_EQ(fake->requests().size(), 8);
+}
+
+TEST_F(TaggedTest, ErrorGoesToItsCaller) {
+    fake->set_respond([](const iface_dynamic_req_t &req) {
+        return req.msg.periph_idx == 1 ? FakeInterface::error(JABI_PERIPHERAL_ERR) : respond(req);
+    });
+    fake->set_delay([](const iface_dynamic_req_t&) { return std::chrono::milliseconds(50); });
+    std::thread bad([&]() { EXPECT_THROW(dev.adc_read(1), std::runtime_error); });
+    wait_sent(1);
+    EXPECT_EQ(dev.adc_read(2), 2);
+    bad.join();
+}
+
+TEST_F(TaggedTest, LinkFailureFailsAllWaiters) {
+    fake->set_delay([](const iface_dynamic_req_t&) { return std::chrono::milliseconds(1000); });
+    std::vector<std::thread> threads;
+    std::atomic<int> num_failed{0};
+    for (int i = 0; i < 3; i++) {
+        threads.emplace_back([&, i]() {
+            try {
+                dev.adc_read(i);
+            } catch (const LinkError&) {
+                num_failed++;
+            }
+        });
+    }
+    wait_sent(3);
+    fake->set_link_down(true);
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(num_failed, 3);
+}
+
+TEST_F(TaggedTest, DisablingWaitsForOutstanding) {
+    fake->set_delay([](const iface_dynamic_req_t&) { return std::chrono::milliseconds(100); });
+    std::thread t([&]() { EXPECT_EQ(dev.adc_read(3), 3); });
+    wait_sent(1);
+    dev.set_tagged(false);
+    t.join();
+
+    EXPECT_EQ(dev.adc_read(4), 4); // untagged again
+    EXPECT_EQ(fake->max_outstanding(), 1);
+}
+
+};
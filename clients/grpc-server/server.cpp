@@ -84,7 +84,7 @@ Status JABIServiceImpl::can_write(ServerContext*, const CANWriteRequest* req, Em
         m.brs  = req->msg().brs();
         m.rtr  = req->msg().rtr();
         auto s = req->msg().data();
-        m.data = std::vector<uint8_t>(s.begin(), s.end());
+        m.data.assign(s.begin(), s.end());
         dev->can_write(m, req->idx());
     )
 }
@@ -277,7 +277,7 @@ Status JABIServiceImpl::lin_write(ServerContext*, const LINWriteRequest* req, Em
         m.id   = req->msg().id();
         m.type = static_cast<jabi::LINChecksum>(req->msg().type());
         auto s = req->msg().data();
-        m.data = std::vector<uint8_t>(s.begin(), s.end());
+        m.data.assign(s.begin(), s.end());
         dev->lin_write(m, req->idx());
     )
 }
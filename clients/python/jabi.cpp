@@ -1,5 +1,7 @@
 #include <sstream>
 
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -17,6 +19,12 @@ py::object can_read_simple(Device &d, int idx) {
     return py::cast(msg);
 }
 
+std::vector<CANMessage> can_read_many_simple(Device &d, size_t max_msgs, int idx, bool timestamps) {
+    std::vector<CANMessage> msgs;
+    d.can_read_many(msgs, max_msgs, idx, timestamps);
+    return msgs;
+}
+
 py::object lin_read_simple(Device &d, int id, int idx) {
     LINMessage msg;
     if (d.lin_read(msg, id, idx) == -1) {
@@ -25,6 +33,21 @@ py::object lin_read_simple(Device &d, int id, int idx) {
     return py::cast(msg);
 }
 
+// Python drops receivers w/ the GIL held while the thread may be waiting on it to
+// run a callback, join w/o it. the callbacks are Python objects, delete w/ it held
+struct CANReceiverDeleter {
+    void operator()(CANReceiver *r) const {
+        {
+            py::gil_scoped_release release;
+            try {
+                r->stop();
+            } catch (...) {} // nowhere to report it, same as ~CANReceiver
+        }
+        delete r;
+    }
+};
+using CANReceiverHolder = std::unique_ptr<CANReceiver, CANReceiverDeleter>;
+
 PYBIND11_MODULE(jabi, m) {
     /* Metadata */
     py::enum_<InstID>(m, "InstID")
@@ -39,17 +62,150 @@ PYBIND11_MODULE(jabi, m) {
         .value("UART", InstID::UART)
         .value("LIN", InstID::LIN);
 
+    py::class_<RXBuffer>(m, "RXBuffer")
+        .def(py::init<>())
+        .def(py::init<InstID, int, size_t>(), "id"_a, "idx"_a, "size"_a)
+        .def_readwrite("id", &RXBuffer::id)
+        .def_readwrite("idx", &RXBuffer::idx)
+        .def_readwrite("size", &RXBuffer::size);
+
+    py::class_<RXArena>(m, "RXArena")
+        .def_readwrite("size", &RXArena::size)
+        .def_readwrite("free", &RXArena::free)
+        .def_readwrite("buffers", &RXArena::buffers);
+
+    py::class_<FuncStats>(m, "FuncStats")
+        .def_readwrite("calls", &FuncStats::calls)
+        .def_readwrite("time", &FuncStats::time);
+
+    py::class_<PeriphStats>(m, "PeriphStats")
+        .def_readwrite("rx", &PeriphStats::rx)
+        .def_readwrite("rx_dropped", &PeriphStats::rx_dropped)
+        .def_readwrite("rx_high", &PeriphStats::rx_high)
+        .def_readwrite("busy", &PeriphStats::busy)
+        .def_readwrite("funcs", &PeriphStats::funcs);
+
+    py::class_<IfaceStats>(m, "IfaceStats")
+        .def_readwrite("rx_bytes", &IfaceStats::rx_bytes)
+        .def_readwrite("tx_bytes", &IfaceStats::tx_bytes)
+        .def_readwrite("errors", &IfaceStats::errors);
+
+    py::class_<LinkStats>(m, "LinkStats")
+        .def_readwrite("count", &LinkStats::count)
+        .def_readwrite("tx_rate", &LinkStats::tx_rate)
+        .def_readwrite("rx_rate", &LinkStats::rx_rate)
+        .def_readwrite("tx_latency", &LinkStats::tx_latency)
+        .def_readwrite("rx_latency", &LinkStats::rx_latency)
+        .def_readwrite("errors", &LinkStats::errors);
+
+    py::class_<OutputStats>(m, "OutputStats")
+        .def_readwrite("sent", &OutputStats::sent)
+        .def_readwrite("dropped", &OutputStats::dropped)
+        .def_readwrite("latency", &OutputStats::latency)
+        .def_readwrite("max_latency", &OutputStats::max_latency);
+
     /* CAN */
     py::enum_<CANMode>(m, "CANMode")
         .value("NORMAL", CANMode::NORMAL)
         .value("LOOPBACK", CANMode::LOOPBACK)
         .value("LISTENONLY", CANMode::LISTENONLY);
 
+    py::class_<CANFilter>(m, "CANFilter")
+        .def(py::init<>())
+        .def_readwrite("id", &CANFilter::id)
+        .def_readwrite("id_mask", &CANFilter::id_mask)
+        .def_readwrite("ext", &CANFilter::ext);
+
     py::class_<CANState>(m, "CANState")
         .def_readwrite("state", &CANState::state)
         .def_readwrite("tx_err", &CANState::tx_err)
         .def_readwrite("rx_err", &CANState::rx_err);
 
+    py::class_<CANIdCount>(m, "CANIdCount")
+        .def_readwrite("id", &CANIdCount::id)
+        .def_readwrite("ext", &CANIdCount::ext)
+        .def_readwrite("count", &CANIdCount::count);
+
+    py::class_<CANBusStats>(m, "CANBusStats")
+        .def_readwrite("rx_frames", &CANBusStats::rx_frames)
+        .def_readwrite("rx_bytes", &CANBusStats::rx_bytes)
+        .def_readwrite("tx_frames", &CANBusStats::tx_frames)
+        .def_readwrite("tx_bytes", &CANBusStats::tx_bytes)
+        .def_readwrite("rx_frame_rate", &CANBusStats::rx_frame_rate)
+        .def_readwrite("rx_byte_rate", &CANBusStats::rx_byte_rate)
+        .def_readwrite("tx_frame_rate", &CANBusStats::tx_frame_rate)
+        .def_readwrite("tx_byte_rate", &CANBusStats::tx_byte_rate)
+        .def_readwrite("bus_load", &CANBusStats::bus_load)
+        .def_readwrite("bit0_errors", &CANBusStats::bit0_errors)
+        .def_readwrite("bit1_errors", &CANBusStats::bit1_errors)
+        .def_readwrite("stuff_errors", &CANBusStats::stuff_errors)
+        .def_readwrite("crc_errors", &CANBusStats::crc_errors)
+        .def_readwrite("form_errors", &CANBusStats::form_errors)
+        .def_readwrite("ack_errors", &CANBusStats::ack_errors)
+        .def_readwrite("rx_overruns", &CANBusStats::rx_overruns)
+        .def_readwrite("error_warning", &CANBusStats::error_warning)
+        .def_readwrite("error_passive", &CANBusStats::error_passive)
+        .def_readwrite("bus_off", &CANBusStats::bus_off)
+        .def_readwrite("filtered", &CANBusStats::filtered)
+        .def_readwrite("top_ids", &CANBusStats::top_ids);
+
+    py::class_<CANTxStats>(m, "CANTxStats")
+        .def_readwrite("queued", &CANTxStats::queued)
+        .def_readwrite("sent", &CANTxStats::sent)
+        .def_readwrite("failed", &CANTxStats::failed)
+        .def_readwrite("pending", &CANTxStats::pending);
+
+    py::enum_<CANChecksum>(m, "CANChecksum")
+        .value("NONE", CANChecksum::NONE)
+        .value("XOR", CANChecksum::XOR)
+        .value("SUM", CANChecksum::SUM)
+        .value("CRC8_SAE_J1850", CANChecksum::CRC8_SAE_J1850);
+
+    py::class_<CANCyclic>(m, "CANCyclic")
+        .def(py::init<>())
+        .def_readwrite("msg", &CANCyclic::msg)
+        .def_readwrite("period_us", &CANCyclic::period_us)
+        .def_readwrite("offset_us", &CANCyclic::offset_us)
+        .def_readwrite("counter_byte", &CANCyclic::counter_byte)
+        .def_readwrite("counter_bits", &CANCyclic::counter_bits)
+        .def_readwrite("checksum_byte", &CANCyclic::checksum_byte)
+        .def_readwrite("checksum", &CANCyclic::checksum);
+
+    py::class_<CANCyclicStats>(m, "CANCyclicStats")
+        .def_readwrite("slot", &CANCyclicStats::slot)
+        .def_readwrite("period_us", &CANCyclicStats::period_us)
+        .def_readwrite("sent", &CANCyclicStats::sent)
+        .def_readwrite("missed", &CANCyclicStats::missed);
+
+    py::class_<CANRoute>(m, "CANRoute")
+        .def(py::init<>())
+        .def_readwrite("id", &CANRoute::id)
+        .def_readwrite("id_mask", &CANRoute::id_mask)
+        .def_readwrite("ext", &CANRoute::ext)
+        .def_readwrite("dst", &CANRoute::dst)
+        .def_readwrite("rewrite_mask", &CANRoute::rewrite_mask)
+        .def_readwrite("new_id", &CANRoute::new_id);
+
+    py::class_<CANRouteStats>(m, "CANRouteStats")
+        .def_readwrite("route", &CANRouteStats::route)
+        .def_readwrite("dst", &CANRouteStats::dst)
+        .def_readwrite("forwarded", &CANRouteStats::forwarded)
+        .def_readwrite("dropped", &CANRouteStats::dropped);
+
+    py::class_<ISOTPConfig>(m, "ISOTPConfig")
+        .def(py::init<>())
+        .def_readwrite("tx_id", &ISOTPConfig::tx_id)
+        .def_readwrite("rx_id", &ISOTPConfig::rx_id)
+        .def_readwrite("ext", &ISOTPConfig::ext)
+        .def_readwrite("fd", &ISOTPConfig::fd)
+        .def_readwrite("brs", &ISOTPConfig::brs)
+        .def_readwrite("tx_dl", &ISOTPConfig::tx_dl)
+        .def_readwrite("ext_addr", &ISOTPConfig::ext_addr)
+        .def_readwrite("tx_ext_addr", &ISOTPConfig::tx_ext_addr)
+        .def_readwrite("rx_ext_addr", &ISOTPConfig::rx_ext_addr)
+        .def_readwrite("bs", &ISOTPConfig::bs)
+        .def_readwrite("stmin", &ISOTPConfig::stmin);
+
     py::class_<CANMessage>(m, "CANMessage")
         .def(py::init<>())
         .def(py::init<int, int, bool, bool>(),
@@ -61,7 +217,11 @@ PYBIND11_MODULE(jabi, m) {
         .def_readwrite("fd", &CANMessage::fd)
         .def_readwrite("brs", &CANMessage::brs)
         .def_readwrite("rtr", &CANMessage::rtr)
-        .def_readwrite("data", &CANMessage::data) // Note can't set individual elements
+        .def_readwrite("timestamp", &CANMessage::timestamp)
+        .def_readwrite("hw_timestamp", &CANMessage::hw_timestamp)
+        .def_property("data", // Note can't set individual elements
+            [](const CANMessage &m){ return std::vector<uint8_t>(m.data); },
+            [](CANMessage &m, std::vector<uint8_t> d){ m.data = d; })
         .def("__repr__", [](const CANMessage &m){
             std::stringstream s; s << m; return s.str(); });
 
@@ -122,7 +282,9 @@ PYBIND11_MODULE(jabi, m) {
             "id"_a, "data"_a, "type"_a=LINChecksum::ENHANCED)
         .def_readwrite("id", &LINMessage::id)
         .def_readwrite("type", &LINMessage::type)
-        .def_readwrite("data", &LINMessage::data) // Note can't set individual elements
+        .def_property("data", // Note can't set individual elements
+            [](const LINMessage &m){ return std::vector<uint8_t>(m.data); },
+            [](LINMessage &m, std::vector<uint8_t> d){ m.data = d; })
         .def("__repr__", [](const LINMessage &m){
             std::stringstream s; s << m; return s.str(); });
 
@@ -135,15 +297,51 @@ PYBIND11_MODULE(jabi, m) {
         .def("req_max_size", &Device::req_max_size)
         .def("resp_max_size", &Device::resp_max_size)
         .def("custom", &Device::custom)
+        .def("rx_arena", &Device::rx_arena)
+        .def("set_rx_arena", &Device::set_rx_arena, "buffers"_a)
+        .def("periph_stats", &Device::periph_stats, "id"_a, "idx"_a=0)
+        .def("iface_stats", &Device::iface_stats)
+        .def("log_read", &Device::log_read)
+        .def("sink", &Device::sink, "data"_a)
+        .def("source", &Device::source)
+        .def("link_test", &Device::link_test, "count"_a=100)
+
+        /* Connection */
+        .def("set_auto_reconnect", &Device::set_auto_reconnect, "enable"_a)
+        .def("reconnect", &Device::reconnect)
+        .def("set_skip_redundant", &Device::set_skip_redundant, "enable"_a)
+        .def("invalidate_shadow", py::overload_cast<>(&Device::invalidate_shadow))
+        .def("invalidate_shadow", py::overload_cast<InstID, int>(&Device::invalidate_shadow),
+            "id"_a, "idx"_a=0)
+        .def("set_coalesce_reads", &Device::set_coalesce_reads, "enable"_a, "max_age"_a=0.0)
+        .def("set_combine_writes", &Device::set_combine_writes, "enable"_a)
+        .def("flush_writes", &Device::flush_writes)
+        .def("write_stats", &Device::write_stats, "id"_a, "idx"_a)
+        .def("set_tagged", &Device::set_tagged, "enable"_a)
 
         /* CAN */
         .def("can_set_filter", &Device::can_set_filter, "id"_a, "id_mask"_a, "idx"_a=0)
+        .def("can_set_filters", &Device::can_set_filters, "filters"_a, "idx"_a=0)
         .def("can_set_rate", &Device::can_set_rate,
             "bitrate"_a, "bitrate_data"_a, "idx"_a=0)
         .def("can_set_mode", &Device::can_set_mode, "mode"_a, "idx"_a=0)
         .def("can_state", &Device::can_state, "idx"_a=0)
         .def("can_write", &Device::can_write, "msg"_a, "idx"_a=0)
         .def("can_read", &can_read_simple, "idx"_a=0)
+        .def("can_read_many", &can_read_many_simple,
+            "max_msgs"_a=0, "idx"_a=0, "timestamps"_a=false)
+        .def("can_write_many", &Device::can_write_many, "msgs"_a, "idx"_a=0)
+        .def("can_tx_stats", &Device::can_tx_stats, "idx"_a=0)
+        .def("can_bus_stats", &Device::can_bus_stats, "reset_ids"_a=false, "idx"_a=0)
+        .def("can_cyclic_set", &Device::can_cyclic_set, "slot"_a, "entry"_a, "idx"_a=0)
+        .def("can_cyclic_remove", &Device::can_cyclic_remove, "slot"_a, "idx"_a=0)
+        .def("can_cyclic_stats", &Device::can_cyclic_stats, "idx"_a=0)
+        .def("can_route_set", &Device::can_route_set, "route"_a, "cfg"_a, "idx"_a=0)
+        .def("can_route_remove", &Device::can_route_remove, "route"_a, "idx"_a=0)
+        .def("can_route_stats", &Device::can_route_stats, "idx"_a=0)
+        .def("isotp_bind", &Device::isotp_bind, "cfg"_a, "idx"_a=0)
+        .def("isotp_send", &Device::isotp_send, "data"_a, "idx"_a=0)
+        .def("isotp_recv", &Device::isotp_recv, "timeout_ms"_a=1000, "idx"_a=0)
 
         /* I2C */
         .def("i2c_set_freq", &Device::i2c_set_freq, "preset"_a, "idx"_a=0)
@@ -190,6 +388,90 @@ PYBIND11_MODULE(jabi, m) {
         .def("lin_write", &Device::lin_write, "msg"_a, "idx"_a=0)
         .def("lin_read", &lin_read_simple, "id"_a=0xFF, "idx"_a=0);
 
+    /* CAN receiver */
+    py::class_<CANQueue, std::shared_ptr<CANQueue>>(m, "CANQueue")
+        .def("pop", &CANQueue::pop)
+        .def("size", &CANQueue::size)
+        .def("capacity", &CANQueue::capacity)
+        .def("empty", &CANQueue::empty);
+
+    py::class_<CANSubscriberStats>(m, "CANSubscriberStats")
+        .def_readwrite("handle", &CANSubscriberStats::handle)
+        .def_readwrite("idx", &CANSubscriberStats::idx)
+        .def_readwrite("id", &CANSubscriberStats::id)
+        .def_readwrite("ext", &CANSubscriberStats::ext)
+        .def_readwrite("delivered", &CANSubscriberStats::delivered)
+        .def_readwrite("overflows", &CANSubscriberStats::overflows);
+
+    py::class_<CANReceiver, CANReceiverHolder>(m, "CANReceiver")
+        .def(py::init([](Device dev, std::vector<int> idxs, bool timestamps, int poll_us) {
+            return CANReceiverHolder(new CANReceiver(dev, idxs, timestamps,
+                std::chrono::microseconds(poll_us)));
+        }), "dev"_a, "idxs"_a=std::vector<int>{0}, "timestamps"_a=false, "poll_us"_a=1000)
+        .def("subscribe", &CANReceiver::subscribe, "id"_a, "ext"_a, "cb"_a, "idx"_a=0)
+        .def("subscribe_queue", &CANReceiver::subscribe_queue,
+            "id"_a, "ext"_a, "capacity"_a=1024, "idx"_a=0)
+        .def("unsubscribe", &CANReceiver::unsubscribe, "handle"_a)
+        .def("stats", &CANReceiver::stats)
+        .def("start", &CANReceiver::start)
+        .def("stop", &CANReceiver::stop, py::call_guard<py::gil_scoped_release>()) // callbacks need it
+        .def("running", &CANReceiver::running);
+
+    py::enum_<DBCValueType>(m, "DBCValueType")
+        .value("INTEGER", DBCValueType::INTEGER)
+        .value("FLOAT", DBCValueType::FLOAT)
+        .value("DOUBLE", DBCValueType::DOUBLE);
+
+    py::class_<DBCSignal>(m, "DBCSignal")
+        .def_readwrite("name", &DBCSignal::name)
+        .def_readwrite("start", &DBCSignal::start)
+        .def_readwrite("len", &DBCSignal::len)
+        .def_readwrite("little_endian", &DBCSignal::little_endian)
+        .def_readwrite("is_signed", &DBCSignal::is_signed)
+        .def_readwrite("factor", &DBCSignal::factor)
+        .def_readwrite("offset", &DBCSignal::offset)
+        .def_readwrite("min", &DBCSignal::min)
+        .def_readwrite("max", &DBCSignal::max)
+        .def_readwrite("unit", &DBCSignal::unit)
+        .def_readwrite("is_mux", &DBCSignal::is_mux)
+        .def_readwrite("mux", &DBCSignal::mux)
+        .def_readwrite("type", &DBCSignal::type);
+
+    py::class_<DBCMessage>(m, "DBCMessage")
+        .def_readwrite("id", &DBCMessage::id)
+        .def_readwrite("ext", &DBCMessage::ext)
+        .def_readwrite("name", &DBCMessage::name)
+        .def_readwrite("dlc", &DBCMessage::dlc)
+        .def_readwrite("signals", &DBCMessage::signals);
+
+    py::class_<DBCColumns>(m, "DBCColumns")
+        .def_readwrite("id", &DBCColumns::id)
+        .def_readwrite("ext", &DBCColumns::ext)
+        .def_readwrite("name", &DBCColumns::name)
+        .def_readwrite("signals", &DBCColumns::signals)
+        // numpy views of the columns, the DBCColumns object owns the memory
+        .def_property_readonly("timestamps", [](py::object self) {
+            auto &c = self.cast<DBCColumns&>();
+            return py::array_t<uint64_t>(c.timestamps.size(), c.timestamps.data(), self);
+        })
+        .def_property_readonly("values", [](py::object self) {
+            auto &c = self.cast<DBCColumns&>();
+            py::list ret;
+            for (auto &col : c.values) {
+                ret.append(py::array_t<double>(col.size(), col.data(), self));
+            }
+            return ret;
+        });
+
+    py::class_<DBC>(m, "DBC")
+        .def_static("load", &DBC::load, "path"_a)
+        .def_static("parse", &DBC::parse, "text"_a)
+        .def("messages", &DBC::messages)
+        .def("find", &DBC::find, "id"_a, "ext"_a=false, py::return_value_policy::reference_internal)
+        .def("decode", py::overload_cast<const CANMessage&>(&DBC::decode, py::const_), "msg"_a)
+        .def("decode", py::overload_cast<const std::vector<CANMessage>&>(&DBC::decode, py::const_),
+            "msgs"_a);
+
     /* Interfaces */
     py::class_<USBInterface>(m, "USBInterface")
         .def("list_devices", &USBInterface::list_devices);
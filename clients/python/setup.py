@@ -74,6 +74,7 @@ setup(ext_modules=[
             "jabi.cpp",
             *sorted(glob("tmp/clients/cpp/libjabi/interfaces/*.cpp")),
             *sorted(glob("tmp/clients/cpp/libjabi/peripherals/*.cpp")),
+            *sorted(glob("tmp/clients/cpp/libjabi/can/*.cpp")),
         ],
         include_dirs = [
             "tmp/clients/cpp",
@@ -0,0 +1,124 @@
+import gc
+import math
+import os
+import struct
+import threading
+import time
+import tty
+
+import numpy as np
+import pytest
+
+import jabi
+
+# from include/jabi
+PERIPH_METADATA_ID = 0
+PERIPH_CAN_ID = 1
+METADATA_REQ_MAX_SIZE_ID = 3
+METADATA_RESP_MAX_SIZE_ID = 4
+CAN_READ_MANY_ID = 6
+MAX_SIZE = 128
+
+DBC_TEXT = """
+VERSION ""
+
+BO_ 291 ENGINE: 8 ECU
+ SG_ RPM : 0|16@1+ (0.25,0) [0|16383.75] "rpm" Vector__XXX
+ SG_ TEMP : 16|8@1- (1,-40) [-168|87] "degC" Vector__XXX
+"""
+
+
+class FakeDevice:
+    """Answers the UART interface on a pty, every CAN read returns one 0x123 frame"""
+
+    def __init__(self):
+        self.master, self.slave = os.openpty()
+        tty.setraw(self.slave)
+        self.port = os.ttyname(self.slave)
+        self.reads = 0
+        self.done = False
+        self.thread = threading.Thread(target=self.run, daemon=True)
+        self.thread.start()
+
+    def close(self):
+        self.done = True
+        os.close(self.slave) # master reads fail once the host closes too, ends run()
+        self.thread.join(timeout=1)
+        os.close(self.master)
+
+    def read(self, n):
+        buf = b""
+        while len(buf) < n:
+            chunk = os.read(self.master, n - len(buf))
+            if not chunk:
+                raise OSError("pty closed")
+            buf += chunk
+        return buf
+
+    def run(self):
+        try:
+            while not self.done:
+                periph_id, _, periph_fn, payload_len = struct.unpack("<HHHH", self.read(8))
+                self.read(payload_len)
+                payload = b""
+                if periph_id == PERIPH_METADATA_ID and periph_fn in (METADATA_REQ_MAX_SIZE_ID,
+                                                                     METADATA_RESP_MAX_SIZE_ID):
+                    payload = struct.pack("<H", MAX_SIZE)
+                elif periph_id == PERIPH_CAN_ID and periph_fn == CAN_READ_MANY_ID:
+                    self.reads += 1
+                    payload = struct.pack("<HHIBBBBB", 0, 1, 0x123, 0, 0, 0, 0, 2) + bytes([0x10, 0x27])
+                os.write(self.master, struct.pack("<hH", 0, len(payload)) + payload)
+        except OSError:
+            pass
+
+
+@pytest.fixture
+def fake():
+    f = FakeDevice()
+    yield f
+    f.close()
+
+
+def test_dbc_columns_are_numpy():
+    dbc = jabi.DBC.parse(DBC_TEXT)
+    msgs = [
+        jabi.CANMessage(0x123, [0x10, 0x27, 0x64, 0, 0, 0, 0, 0]),
+        jabi.CANMessage(0x123, [0x20, 0x4E]), # too short for TEMP
+        jabi.CANMessage(0x456, [0, 0]), # unknown
+    ]
+    cols = dbc.decode(msgs)
+    assert len(cols) == 1
+    c = cols[0]
+    assert c.name == "ENGINE"
+    assert c.signals == ["RPM", "TEMP"]
+
+    rpm, temp = c.values
+    assert isinstance(rpm, np.ndarray)
+    assert rpm.dtype == np.float64
+    np.testing.assert_array_equal(rpm, [2500.0, 5000.0])
+    assert temp[0] == 60.0
+    assert math.isnan(temp[1])
+    assert c.timestamps.dtype == np.uint64
+
+    del c, cols # arrays keep the columns alive
+    gc.collect()
+    np.testing.assert_array_equal(rpm, [2500.0, 5000.0])
+
+
+def test_drop_running_receiver(fake):
+    dev = jabi.UARTInterface.get_device(fake.port, 230400)
+    got = []
+    r = jabi.CANReceiver(dev, poll_us=100)
+    r.subscribe(0x123, False, lambda m: got.append(m.id))
+    r.start()
+    deadline = time.monotonic() + 5
+    while len(got) < 10 and time.monotonic() < deadline:
+        time.sleep(0.01)
+    assert len(got) >= 10
+    assert set(got) == {0x123}
+
+    del r # callbacks still coming, must join w/o deadlocking on the GIL
+    gc.collect()
+    reads = fake.reads
+    time.sleep(0.05)
+    assert fake.reads == reads # stopped polling
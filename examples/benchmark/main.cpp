@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <jabi.h>
+
+/* Round trip benchmark, meant for the native_sim build where the firmware
+ * runs as a process w/ its interface UART on a pty. Every peripheral there
+ * is emulated, so numbers are the cost of the link + dispatcher + peripheral
+ * code rather than of any bus.
+ */
+
+struct Result {
+    std::string name;
+    size_t bytes; // payload moved per call, both directions
+    std::vector<double> times; // seconds per call
+    double device_time; // seconds per call spent in the peripheral function
+};
+
+static void print_result(Result &r) {
+    std::sort(r.times.begin(), r.times.end());
+    double total = 0;
+    for (auto t : r.times) { total += t; }
+    double mean = total / r.times.size();
+    double p50 = r.times[r.times.size() / 2];
+    double p99 = r.times[std::min(r.times.size() - 1, r.times.size() * 99 / 100)];
+
+    std::printf("%-18s %9.1f %9.1f %9.1f %9.1f %10.0f %12.0f\n", r.name.c_str(),
+        mean * 1e6, p50 * 1e6, p99 * 1e6, r.device_time * 1e6,
+        r.times.size() / total, r.bytes * r.times.size() / total);
+}
+
+static double device_time(const jabi::PeriphStats &before, const jabi::PeriphStats &after,
+                          const std::vector<bool> &skip) {
+    uint64_t calls = 0;
+    double time = 0;
+    for (size_t i = 0; i < after.funcs.size() && i < before.funcs.size(); i++) {
+        if (i < skip.size() && skip[i]) {
+            continue;
+        }
+        calls += after.funcs[i].calls - before.funcs[i].calls;
+        time += after.funcs[i].time - before.funcs[i].time;
+    }
+    return calls ? time / calls : 0;
+}
+
+// prep runs untimed before each call, the functions it calls stay out of device time
+static Result bench(jabi::Device &d, jabi::InstID id, std::string name, size_t bytes,
+                    int iters, std::function<void()> fn, std::function<void()> prep = nullptr) {
+    Result r = { .name = name, .bytes = bytes, .times = {}, .device_time = 0 };
+    std::vector<bool> skip;
+    if (prep) {
+        auto pre = d.periph_stats(id);
+        prep();
+        auto post = d.periph_stats(id);
+        for (size_t i = 0; i < post.funcs.size() && i < pre.funcs.size(); i++) {
+            skip.push_back(post.funcs[i].calls != pre.funcs[i].calls);
+        }
+    }
+    fn(); // warm up, first call may carry setup
+    auto before = d.periph_stats(id);
+    for (int i = 0; i < iters; i++) {
+        if (prep) { prep(); }
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        r.times.push_back(std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    r.device_time = device_time(before, d.periph_stats(id), skip);
+    return r;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <port> [iterations] [baud]" << std::endl;
+        return 1;
+    }
+    int iters = argc > 2 ? std::stoi(argv[2]) : 1000;
+    int baud = argc > 3 ? std::stoi(argv[3]) : 230400; // ignored by a pty
+
+    auto d = jabi::UARTInterface::get_device(argv[1], baud);
+    std::cout << "SN=" << d.serial() << " iterations=" << iters << std::endl;
+
+    std::vector<Result> results;
+    size_t max = std::min(d.req_max_size(), d.resp_max_size());
+
+    results.push_back(bench(d, jabi::InstID::METADATA, "echo 1", 2, iters,
+        [&]() { d.echo("x"); }));
+    std::string big(max - 1, 'x');
+    results.push_back(bench(d, jabi::InstID::METADATA, "echo max", 2 * big.size(), iters,
+        [&]() { d.echo(big); }));
+
+    if (d.num_inst(jabi::InstID::GPIO) > 0) {
+        d.gpio_set_mode(0, jabi::GPIODir::OUTPUT);
+        bool val = false;
+        results.push_back(bench(d, jabi::InstID::GPIO, "gpio write", 1, iters,
+            [&]() { d.gpio_write(0, val = !val); }));
+        results.push_back(bench(d, jabi::InstID::GPIO, "gpio read", 1, iters,
+            [&]() { d.gpio_read(0); }));
+    }
+
+    if (d.num_inst(jabi::InstID::CAN) > 0) {
+        d.can_set_filter(0, 0);
+        d.can_set_mode(jabi::CANMode::LOOPBACK);
+        jabi::CANMessage msg(0x123, std::vector<uint8_t>{1, 2, 3, 4, 5, 6, 7, 8});
+        results.push_back(bench(d, jabi::InstID::CAN, "can write", 8, iters,
+            [&]() { d.can_write(msg); }));
+        // each read gets a frame looped back right before it, the ring only holds a few
+        jabi::CANMessage rx;
+        results.push_back(bench(d, jabi::InstID::CAN, "can read", 8, iters,
+            [&]() {
+                if (d.can_read(rx) < 0) {
+                    throw std::runtime_error("can read found no looped back frame");
+                }
+            },
+            [&]() { d.can_write(msg); }));
+    }
+
+    if (d.num_inst(jabi::InstID::I2C) > 0) {
+        // emulated eeprom at 0x50, one address byte then data
+        results.push_back(bench(d, jabi::InstID::I2C, "i2c transceive", 17, iters,
+            [&]() { d.i2c_transceive(0x50, std::vector<uint8_t>{0}, 16); }));
+    }
+
+    if (d.num_inst(jabi::InstID::SPI) > 0) {
+        std::vector<uint8_t> data(16, 0x80); // emulated bmi160, reads of reg 0 on
+        results.push_back(bench(d, jabi::InstID::SPI, "spi transceive", 2 * data.size(), iters,
+            [&]() { d.spi_transceive(data); }));
+    }
+
+    std::printf("%-18s %9s %9s %9s %9s %10s %12s\n", "function",
+        "mean(us)", "p50(us)", "p99(us)", "dev(us)", "ops/s", "bytes/s");
+    for (auto &r : results) {
+        print_result(r);
+    }
+
+    auto link = d.link_test(iters);
+    std::printf("\nlink only: tx %.0f bytes/s %.1fus, rx %.0f bytes/s %.1fus, %llu errors\n",
+        link.tx_rate, link.tx_latency * 1e6, link.rx_rate, link.rx_latency * 1e6,
+        static_cast<unsigned long long>(link.errors));
+
+    std::string log = d.log_read();
+    if (!log.empty()) {
+        std::cout << std::endl << "device log:" << std::endl << log;
+    }
+    return 0;
+}
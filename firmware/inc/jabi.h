@@ -2,6 +2,7 @@
 #define JABI_H
 
 #include <zephyr/device.h>
+#include <zephyr/kernel.h>
 #include <jabi/error.h>
 #include <jabi/interfaces.h>
 #include <jabi/peripherals.h>
@@ -14,9 +15,57 @@
 #define NUM_INTERFACES (DT_PROP(JABI_IFACE_NODE, usb) + \
                         DT_PROP_LEN(JABI_IFACE_NODE, uart))
 
+#define IFACE_IDX_USB     0 // order of interfaces[]
+#define IFACE_IDX_UART(n) (DT_PROP(JABI_IFACE_NODE, usb) + (n))
+
 extern void iface_req_to_le(iface_req_t *req);
 extern void iface_resp_to_le(iface_resp_t *resp);
 
+extern iface_req_t  *iface_req_alloc(k_timeout_t timeout); // NULL on timeout
+extern void          iface_req_free(iface_req_t *req);
+extern iface_resp_t *iface_resp_alloc(k_timeout_t timeout);
+extern void          iface_resp_free(iface_resp_t *resp);
+
+/* Counters reported through metadata, never reset so the host diffs them */
+typedef struct {
+    atomic_t rx_bytes;
+    atomic_t tx_bytes;
+    atomic_t errors; // dropped/malformed packets and error responses
+} iface_stats_t;
+
+typedef struct periph_stats {
+    atomic_t rx;         // frames received, bytes for uart
+    atomic_t rx_dropped; // of those, lost to a full queue
+    atomic_t rx_high;    // queue high water mark, bytes
+    atomic_t busy;       // JABI_BUSY_ERR responses
+} periph_stats_t;
+
+typedef struct periph_fn_stats {
+    uint32_t calls;
+    uint64_t cycles; // spent in the function, lock wait excluded
+} periph_fn_stats_t;
+
+extern iface_stats_t iface_stats[NUM_INTERFACES];
+extern periph_stats_t *periph_stats(uint16_t periph_id, uint16_t idx);
+extern void periph_fn_stats(uint16_t periph_id, uint16_t fn, periph_fn_stats_t *stats);
+
+static inline void periph_stats_rx(periph_stats_t *s, uint32_t rx, uint32_t dropped,
+                                   uint32_t queued) {
+    atomic_add(&s->rx, rx);
+    if (dropped) {
+        atomic_add(&s->rx_dropped, dropped);
+    }
+    if (queued > (uint32_t) atomic_get(&s->rx_high)) { // producers are ISRs
+        atomic_set(&s->rx_high, queued);
+    }
+}
+
+extern size_t jabi_log_read(uint8_t *buf, size_t len); // CONFIG_JABI_LOG_BACKEND
+
+extern uint64_t jabi_time_us(void); // since boot, cycle counter resolution, ISR safe
+
+#define CAN_RX_ITEM_SIZE (6 + 10 + CAN_MAX_DLEN) // largest packed rx record, header, timestamps then data
+
 #define ELEM_TO_DEVICE(node_id, prop, idx) \
     DEVICE_DT_GET(DT_PROP_BY_IDX(node_id, prop, idx)),
 
@@ -1,4 +1,5 @@
 #include <zephyr/device.h>
+#include <zephyr/kernel.h>
 #include <zephyr/sys/byteorder.h>
 #include <jabi.h>
 
@@ -18,6 +19,28 @@ const struct iface_api_t *interfaces[] = {
     DT_FOREACH_PROP_ELEM(JABI_IFACE_NODE, uart, GEN_UART_ARRAY)
 };
 
+/* Buffers shared by all interfaces, borrowed per request */
+K_MEM_SLAB_DEFINE_STATIC(req_pool, ROUND_UP(sizeof(iface_req_t), 4), CONFIG_JABI_REQ_BUFFERS, 4);
+K_MEM_SLAB_DEFINE_STATIC(resp_pool, ROUND_UP(sizeof(iface_resp_t), 4), CONFIG_JABI_RESP_BUFFERS, 4);
+
+iface_req_t *iface_req_alloc(k_timeout_t timeout) {
+    void *buf;
+    return k_mem_slab_alloc(&req_pool, &buf, timeout) ? NULL : buf;
+}
+
+void iface_req_free(iface_req_t *req) {
+    k_mem_slab_free(&req_pool, req);
+}
+
+iface_resp_t *iface_resp_alloc(k_timeout_t timeout) {
+    void *buf;
+    return k_mem_slab_alloc(&resp_pool, &buf, timeout) ? NULL : buf;
+}
+
+void iface_resp_free(iface_resp_t *resp) {
+    k_mem_slab_free(&resp_pool, resp);
+}
+
 void iface_req_to_le(iface_req_t *req) {
     req->periph_id = sys_le16_to_cpu(req->periph_id);
     req->periph_idx = sys_le16_to_cpu(req->periph_idx);
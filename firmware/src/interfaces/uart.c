@@ -1,5 +1,6 @@
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
 #include <jabi.h>
 
 #include <zephyr/logging/log.h>
@@ -8,102 +9,250 @@ LOG_MODULE_REGISTER(iface_uart, CONFIG_LOG_DEFAULT_LEVEL);
 #if (DT_PROP_LEN(JABI_IFACE_NODE, uart) > 0)
 
 #define TIMEOUT K_MSEC(10)
+#define RX_IDLE_US 100 // async only, flush partial DMA buffer after this
 
-static int read(struct k_msgq *msgq, uint8_t *buf, size_t len, k_timeout_t time) {
-    for (int i = 0; i < len; i++) {
-        if (k_msgq_get(msgq, &buf[i], time)) {
-            return -1;
+typedef struct {
+    const struct device *dev;
+    int num;
+
+    struct ring_buf rx; // ISR/callback produces, interface thread consumes
+    uint8_t rx_buf[sizeof(iface_req_t)];
+    struct k_sem rx_ready;
+    atomic_t rx_overflow;
+
+    struct k_mutex tx_lock; // workers may respond concurrently
+    struct k_sem tx_done;
+    const uint8_t *tx_buf;
+    size_t tx_len;
+
+#ifdef CONFIG_UART_ASYNC_API
+    bool async;
+    uint8_t dma_bufs[2][CONFIG_JABI_UART_DMA_BUFFER_SIZE];
+    int dma_next;
+#endif // CONFIG_UART_ASYNC_API
+} uart_iface_data_t;
+
+#define GEN_UART_IFACE_DATA(node_id, prop, idx)                   \
+    {                                                             \
+        .dev = DEVICE_DT_GET(DT_PROP_BY_IDX(node_id, prop, idx)), \
+        .num = idx,                                               \
+    },
+
+static uart_iface_data_t uart_ifaces[] = {
+    DT_FOREACH_PROP_ELEM(JABI_IFACE_NODE, uart, GEN_UART_IFACE_DATA)
+};
+
+static void uart_rx_put(uart_iface_data_t *u, const uint8_t *data, size_t len) {
+    if (ring_buf_put(&u->rx, data, len) != len) {
+        atomic_set(&u->rx_overflow, 1);
+    }
+    k_sem_give(&u->rx_ready);
+}
+
+static void uart_irq_handler(const struct device *dev, void *user_data) {
+    uart_iface_data_t *u = user_data;
+    while (uart_irq_update(dev) && uart_irq_is_pending(dev)) {
+        if (uart_irq_rx_ready(dev)) {
+            // read straight into the ring, wrap picked up next time around
+            uint8_t *data;
+            uint32_t space = ring_buf_put_claim(&u->rx, &data, sizeof(u->rx_buf));
+            if (space == 0) {
+                uint8_t discard[16];
+                uart_fifo_read(dev, discard, sizeof(discard));
+                atomic_set(&u->rx_overflow, 1);
+                continue;
+            }
+            int len = uart_fifo_read(dev, data, space);
+            if (len < 0) {
+                LOG_ERR("failed to read UART%d?!", u->num);
+                len = 0;
+            }
+            ring_buf_put_finish(&u->rx, len);
+            if (len) {
+                k_sem_give(&u->rx_ready);
+            }
         }
+
+        if (uart_irq_tx_ready(dev)) {
+            if (!u->tx_len) {
+                uart_irq_tx_disable(dev);
+                k_sem_give(&u->tx_done);
+                continue;
+            }
+            int len = uart_fifo_fill(dev, u->tx_buf, u->tx_len);
+            u->tx_len -= len;
+            u->tx_buf += len;
+        }
+    }
+}
+
+#ifdef CONFIG_UART_ASYNC_API
+static int uart_async_rx_enable(uart_iface_data_t *u) {
+    uint8_t *buf = u->dma_bufs[u->dma_next];
+    u->dma_next ^= 1;
+    return uart_rx_enable(u->dev, buf, sizeof(u->dma_bufs[0]), RX_IDLE_US);
+}
+
+static void uart_async_handler(const struct device *dev, struct uart_event *evt, void *user_data) {
+    uart_iface_data_t *u = user_data;
+    switch (evt->type) {
+        case UART_RX_RDY:
+            uart_rx_put(u, evt->data.rx.buf + evt->data.rx.offset, evt->data.rx.len);
+            break;
+
+        case UART_RX_BUF_REQUEST:
+            uart_rx_buf_rsp(dev, u->dma_bufs[u->dma_next], sizeof(u->dma_bufs[0]));
+            u->dma_next ^= 1;
+            break;
+
+        case UART_RX_STOPPED:
+            LOG_ERR("UART%d rx error, restarting", u->num);
+            break;
+
+        case UART_RX_DISABLED:
+            if (uart_async_rx_enable(u)) {
+                LOG_ERR("failed to restart UART%d rx", u->num);
+            }
+            break;
+
+        case UART_TX_DONE:
+        case UART_TX_ABORTED:
+            k_sem_give(&u->tx_done);
+            break;
+
+        default:
+            break;
     }
+}
+#endif // CONFIG_UART_ASYNC_API
+
+static int uart_iface_init(uart_iface_data_t *u) {
+    ring_buf_init(&u->rx, sizeof(u->rx_buf), u->rx_buf);
+    k_sem_init(&u->rx_ready, 0, 1);
+    k_mutex_init(&u->tx_lock);
+    k_sem_init(&u->tx_done, 0, 1);
+
+#ifdef CONFIG_UART_ASYNC_API
+    if (uart_callback_set(u->dev, uart_async_handler, u) == 0) {
+        u->async = true;
+        if (uart_async_rx_enable(u) == 0) {
+            return 0;
+        }
+        LOG_WRN("UART%d async rx failed, using interrupts", u->num); // e.g. no DMA channel
+        uart_callback_set(u->dev, NULL, NULL);
+        u->async = false;
+    }
+#endif // CONFIG_UART_ASYNC_API
+
+    uart_irq_callback_user_data_set(u->dev, uart_irq_handler, u);
+    uart_irq_rx_enable(u->dev);
     return 0;
 }
 
-#define CREATE_UART_API(node_id, prop, idx)                                           \
-    K_MSGQ_DEFINE(uart##idx##rx, 1, sizeof(iface_req_t), 1);                          \
-                                                                                      \
-    K_SEM_DEFINE(uart##idx##tx_lock, 0, 1);                                           \
-    size_t uart##idx##tx_len;                                                         \
-    uint8_t *uart##idx##tx_buf;                                                       \
-                                                                                      \
-    static void uart##idx##_handler(const struct device *dev, void *data) {           \
-        ARG_UNUSED(data);                                                             \
-        while (uart_irq_update(dev) && uart_irq_is_pending(dev)) {                    \
-            if (uart_irq_rx_ready(dev)) {                                             \
-                uint8_t buffer[64];                                                   \
-                int len = uart_fifo_read(dev, buffer, sizeof(buffer));                \
-                if (len < 0) {                                                        \
-                    LOG_ERR("failed to read UART" #idx "?!");                         \
-                    continue;                                                         \
-                }                                                                     \
-                for (int i = 0; i < len; i++) {                                       \
-                    if (k_msgq_put(&uart##idx##rx, &buffer[i], K_NO_WAIT)) {          \
-                        LOG_ERR("UART" #idx " buffer full! purging queue...");        \
-                        k_msgq_purge(&uart##idx##rx);                                 \
-                        break;                                                        \
-                    }                                                                 \
-                }                                                                     \
-            }                                                                         \
-                                                                                      \
-            if (uart_irq_tx_ready(dev)) {                                             \
-                if (!uart##idx##tx_len) {                                             \
-                    uart_irq_tx_disable(dev);                                         \
-                    k_sem_give(&uart##idx##tx_lock);                                  \
-                    continue;                                                         \
-                }                                                                     \
-                int len = uart_fifo_fill(dev, uart##idx##tx_buf, uart##idx##tx_len);  \
-                uart##idx##tx_len -= len;                                             \
-                uart##idx##tx_buf += len;                                             \
-            }                                                                         \
-        }                                                                             \
-    }                                                                                 \
-                                                                                      \
-    static int uart##idx##_init() {                                                   \
-        const struct device *dev = DEVICE_DT_GET(DT_PROP_BY_IDX(node_id, prop, idx)); \
-        uart_irq_callback_set(dev, uart##idx##_handler);                              \
-        uart_irq_rx_enable(dev);                                                      \
-        return 0;                                                                     \
-    }                                                                                 \
-                                                                                      \
-    static void uart##idx##_get_req(iface_req_t *req) {                               \
-        while (1) {                                                                   \
-            read(&uart##idx##rx, (uint8_t*) req, 1, K_FOREVER);                       \
-            if (read(&uart##idx##rx, ((uint8_t*) req) + 1,                            \
-                    IFACE_REQ_HDR_SIZE - 1, TIMEOUT)) {                               \
-                LOG_ERR("UART" #idx " timeout waiting for header");                   \
-                continue;                                                             \
-            }                                                                         \
-            iface_req_to_le(req);                                                     \
-            if (req->payload_len > REQ_PAYLOAD_MAX_SIZE) {                            \
-                LOG_ERR("UART" #idx " bad req payload length %d", req->payload_len);  \
-                k_msgq_purge(&uart##idx##rx);                                         \
-                continue;                                                             \
-            }                                                                         \
-            if (read(&uart##idx##rx, req->payload, req->payload_len, TIMEOUT)) {      \
-                LOG_ERR("UART" #idx " timeout waiting for payload");                  \
-                continue;                                                             \
-            }                                                                         \
-            break;                                                                    \
-        }                                                                             \
-    }                                                                                 \
-                                                                                      \
-    static void uart##idx##_send_resp(iface_resp_t *resp) {                           \
-        const struct device *dev = DEVICE_DT_GET(DT_PROP_BY_IDX(node_id, prop, idx)); \
-        if (resp->payload_len > RESP_PAYLOAD_MAX_SIZE) {                              \
-            LOG_ERR("UART" #idx " bad resp payload length %d", resp->payload_len);    \
-            return;                                                                   \
-        }                                                                             \
-        uart##idx##tx_len = IFACE_RESP_HDR_SIZE + resp->payload_len;                  \
-        uart##idx##tx_buf = (uint8_t*) resp;                                          \
-        iface_resp_to_le(resp);                                                       \
-        uart_irq_tx_enable(dev);                                                      \
-        k_sem_take(&uart##idx##tx_lock, K_FOREVER);                                   \
-    }                                                                                 \
-                                                                                      \
-    const struct iface_api_t uart##idx##_iface_api = {                                \
-        .init = uart##idx##_init,                                                     \
-        .get_req = uart##idx##_get_req,                                               \
-        .send_resp = uart##idx##_send_resp,                                           \
-        .name = "UART" #idx                                                           \
+static int uart_read(uart_iface_data_t *u, uint8_t *buf, size_t len, k_timeout_t time) {
+    while (1) {
+        uint32_t n = ring_buf_get(&u->rx, buf, len);
+        buf += n;
+        len -= n;
+        if (!len) {
+            return 0;
+        }
+        if (k_sem_take(&u->rx_ready, time)) {
+            return -1;
+        }
+    }
+}
+
+static void uart_purge(uart_iface_data_t *u) {
+    ring_buf_get(&u->rx, NULL, sizeof(u->rx_buf));
+}
+
+static iface_req_t *uart_get_req(uart_iface_data_t *u) {
+    iface_req_t *req = iface_req_alloc(K_FOREVER);
+    while (1) {
+        uart_read(u, (uint8_t*) req, 1, K_FOREVER);
+        if (uart_read(u, ((uint8_t*) req) + 1, IFACE_REQ_HDR_SIZE - 1, TIMEOUT)) {
+            LOG_ERR("UART%d timeout waiting for header", u->num);
+            atomic_inc(&iface_stats[IFACE_IDX_UART(u->num)].errors);
+            continue;
+        }
+        iface_req_to_le(req);
+        if (req->payload_len > REQ_PAYLOAD_MAX_SIZE + IFACE_TAG_SIZE) {
+            LOG_ERR("UART%d bad req payload length %d", u->num, req->payload_len);
+            atomic_inc(&iface_stats[IFACE_IDX_UART(u->num)].errors);
+            uart_purge(u);
+            continue;
+        }
+        if (uart_read(u, req->payload, req->payload_len, TIMEOUT)) {
+            LOG_ERR("UART%d timeout waiting for payload", u->num);
+            atomic_inc(&iface_stats[IFACE_IDX_UART(u->num)].errors);
+            continue;
+        }
+        if (atomic_clear(&u->rx_overflow)) {
+            LOG_ERR("UART%d buffer full! purging...", u->num);
+            atomic_inc(&iface_stats[IFACE_IDX_UART(u->num)].errors);
+            uart_purge(u);
+            continue;
+        }
+        return req;
+    }
+}
+
+static iface_resp_t *uart_alloc_resp() {
+    return iface_resp_alloc(K_FOREVER);
+}
+
+static void uart_send_resp(uart_iface_data_t *u, iface_resp_t *resp) {
+    if (resp->payload_len > RESP_PAYLOAD_MAX_SIZE + IFACE_TAG_SIZE) {
+        LOG_ERR("UART%d bad resp payload length %d", u->num, resp->payload_len);
+        atomic_inc(&iface_stats[IFACE_IDX_UART(u->num)].errors);
+        iface_resp_free(resp);
+        return;
+    }
+    size_t len = IFACE_RESP_HDR_SIZE + resp->payload_len;
+    iface_resp_to_le(resp);
+
+    k_mutex_lock(&u->tx_lock, K_FOREVER);
+#ifdef CONFIG_UART_ASYNC_API
+    if (u->async) {
+        if (uart_tx(u->dev, (uint8_t*) resp, len, SYS_FOREVER_US) == 0) {
+            k_sem_take(&u->tx_done, K_FOREVER);
+        } else {
+            LOG_ERR("UART%d failed to send response", u->num);
+            atomic_inc(&iface_stats[IFACE_IDX_UART(u->num)].errors);
+        }
+    } else
+#endif // CONFIG_UART_ASYNC_API
+    {
+        u->tx_len = len;
+        u->tx_buf = (uint8_t*) resp;
+        uart_irq_tx_enable(u->dev);
+        k_sem_take(&u->tx_done, K_FOREVER);
+    }
+    k_mutex_unlock(&u->tx_lock);
+    iface_resp_free(resp);
+}
+
+#define CREATE_UART_API(node_id, prop, idx)                             \
+    static int uart##idx##_init() {                                     \
+        return uart_iface_init(&uart_ifaces[idx]);                      \
+    }                                                                   \
+                                                                        \
+    static iface_req_t *uart##idx##_get_req() {                         \
+        return uart_get_req(&uart_ifaces[idx]);                         \
+    }                                                                   \
+                                                                        \
+    static void uart##idx##_send_resp(iface_resp_t *resp) {             \
+        uart_send_resp(&uart_ifaces[idx], resp);                        \
+    }                                                                   \
+                                                                        \
+    const struct iface_api_t uart##idx##_iface_api = {                  \
+        .init = uart##idx##_init,                                       \
+        .get_req = uart##idx##_get_req,                                 \
+        .free_req = iface_req_free,                                     \
+        .alloc_resp = uart_alloc_resp,                                  \
+        .send_resp = uart##idx##_send_resp,                             \
+        .name = "UART" #idx                                             \
     };
 
 DT_FOREACH_PROP_ELEM(JABI_IFACE_NODE, uart, CREATE_UART_API)
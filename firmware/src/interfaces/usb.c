@@ -57,6 +57,9 @@ USBD_STRING_DESCR_USER_DEFINE(primary) struct {
     .bString = JABI_IF_STR,
 };
 
+static void usb_status_cb(struct usb_cfg_data *cfg, enum usb_dc_status_code status,
+                          const uint8_t *param);
+
 static struct usb_ep_cfg_data ep_cfg[] = {
     {
         .ep_cb = usb_transfer_ep_callback,
@@ -134,7 +137,7 @@ USBD_DEFINE_CFG_DATA(usb_config) = {
     .usb_device_description = NULL,
     .interface_descriptor = &usb_if_desc.if0,
     .interface_config = usb_jabi_interface_config,
-    .cb_usb_status = NULL,
+    .cb_usb_status = usb_status_cb,
     .interface = {
         .class_handler = NULL,
         .vendor_handler = vendor_handler,
@@ -144,46 +147,161 @@ USBD_DEFINE_CFG_DATA(usb_config) = {
     .endpoint = ep_cfg,
 };
 
+/* Transfer pipeline, an OUT transfer is kept posted into a pool buffer so the
+ * next request arrives while the current one is processed, and responses are
+ * built in place then queued for the IN endpoint.
+ */
+typedef struct {
+    void *buf;
+    size_t len;
+} usb_xfer_t;
+
+static struct k_spinlock xfer_lock;
+static iface_req_t *rx_cur; // NULL when no OUT transfer posted
+static usb_xfer_t tx_cur;
+K_MSGQ_DEFINE(rx_done, sizeof(usb_xfer_t), CONFIG_JABI_REQ_BUFFERS, 4);
+K_MSGQ_DEFINE(tx_queued, sizeof(usb_xfer_t), CONFIG_JABI_RESP_BUFFERS, 4);
+
+static void rx_cb(uint8_t ep, int tsize, void *priv);
+static void tx_cb(uint8_t ep, int tsize, void *priv);
+
+static void post_rx(k_timeout_t timeout) {
+    if (rx_cur) {
+        return;
+    }
+    iface_req_t *req = iface_req_alloc(timeout);
+    if (!req) {
+        return; // thread posts once a buffer frees up
+    }
+    k_spinlock_key_t key = k_spin_lock(&xfer_lock);
+    if (!rx_cur && usb_transfer(ep_cfg[0].ep_addr, (uint8_t*) req, sizeof(iface_req_t),
+                                USB_TRANS_READ, rx_cb, NULL) == 0) {
+        rx_cur = req;
+        req = NULL;
+    }
+    k_spin_unlock(&xfer_lock, key);
+    if (req) {
+        iface_req_free(req); // raced or not configured yet
+    }
+}
+
+static void post_tx() {
+    while (1) {
+        usb_xfer_t failed = {0};
+        k_spinlock_key_t key = k_spin_lock(&xfer_lock);
+        if (!tx_cur.buf && k_msgq_get(&tx_queued, &tx_cur, K_NO_WAIT) == 0) {
+            if (usb_transfer(ep_cfg[1].ep_addr, tx_cur.buf, tx_cur.len,
+                             USB_TRANS_WRITE, tx_cb, NULL)) {
+                failed = tx_cur;
+                tx_cur.buf = NULL;
+            }
+        }
+        k_spin_unlock(&xfer_lock, key);
+        if (!failed.buf) {
+            return;
+        }
+        LOG_ERR("failed to send response");
+        atomic_inc(&iface_stats[IFACE_IDX_USB].errors);
+        iface_resp_free(failed.buf);
+    }
+}
+
+static void rx_cb(uint8_t ep, int tsize, void *priv) {
+    k_spinlock_key_t key = k_spin_lock(&xfer_lock);
+    usb_xfer_t x = { .buf = rx_cur, .len = tsize };
+    rx_cur = NULL;
+    k_spin_unlock(&xfer_lock, key);
+
+    if (x.buf && tsize == -ECANCELED) {
+        iface_req_free(x.buf); // bus reset, nothing was lost
+    } else if (x.buf && tsize < 0) {
+        LOG_ERR("transfer failed");
+        atomic_inc(&iface_stats[IFACE_IDX_USB].errors);
+        iface_req_free(x.buf);
+    } else if (x.buf) {
+        k_msgq_put(&rx_done, &x, K_NO_WAIT);
+    }
+    post_rx(K_NO_WAIT);
+}
+
+static void tx_cb(uint8_t ep, int tsize, void *priv) {
+    k_spinlock_key_t key = k_spin_lock(&xfer_lock);
+    usb_xfer_t x = tx_cur;
+    tx_cur.buf = NULL;
+    k_spin_unlock(&xfer_lock, key);
+
+    if (x.buf) { // also frees responses cancelled by a bus reset
+        if (tsize < 0 || (size_t) tsize != x.len) {
+            LOG_ERR("failed to send response %d", tsize);
+            atomic_inc(&iface_stats[IFACE_IDX_USB].errors);
+        }
+        iface_resp_free(x.buf);
+    }
+    post_tx();
+}
+
+static void usb_status_cb(struct usb_cfg_data *cfg, enum usb_dc_status_code status,
+                          const uint8_t *param) {
+    ARG_UNUSED(cfg);
+    ARG_UNUSED(param);
+    if (status != USB_DC_CONFIGURED) {
+        return;
+    }
+    // transfers cancelled by the reset free their buffers from rx_cb/tx_cb w/
+    // -ECANCELED, until then rx_cur/tx_cur stay set and these don't repost
+    post_rx(K_NO_WAIT);
+    post_tx();
+}
+
 /* JABI API implementation */
 static int usb_init() {
+    post_rx(K_NO_WAIT); // in case already configured
     return 0;
 }
 
-static void usb_get_req(iface_req_t *req) {
+static iface_req_t *usb_get_req() {
     while (1) { // loop until packet received
-        req->payload_len = 0;
-        int len = usb_transfer_sync(ep_cfg[0].ep_addr, (uint8_t*) req,
-                                    sizeof(iface_req_t), USB_TRANS_READ);
-        if (len < 0) {
-            LOG_ERR("transfer failed");
-            continue;
-        }
+        post_rx(K_FOREVER); // callbacks can't wait for a free buffer
+        usb_xfer_t x;
+        k_msgq_get(&rx_done, &x, K_FOREVER);
+        iface_req_t *req = x.buf;
         iface_req_to_le(req);
-        if (req->payload_len > REQ_PAYLOAD_MAX_SIZE || 
-            len != (IFACE_REQ_HDR_SIZE + req->payload_len)) {
-            LOG_ERR("invalid request packet length %d %d", req->payload_len, len);
+        if (req->payload_len > REQ_PAYLOAD_MAX_SIZE + IFACE_TAG_SIZE ||
+            x.len != (IFACE_REQ_HDR_SIZE + req->payload_len)) {
+            LOG_ERR("invalid request packet length %d %d", req->payload_len, (int) x.len);
+            atomic_inc(&iface_stats[IFACE_IDX_USB].errors);
+            iface_req_free(req);
             continue;
         }
-        break;
+        return req;
     }
 }
 
+static void usb_free_req(iface_req_t *req) {
+    iface_req_free(req);
+    post_rx(K_NO_WAIT);
+}
+
+static iface_resp_t *usb_alloc_resp() {
+    return iface_resp_alloc(K_FOREVER);
+}
+
 static void usb_send_resp(iface_resp_t *resp) {
-    if (resp->payload_len > RESP_PAYLOAD_MAX_SIZE) {
+    if (resp->payload_len > RESP_PAYLOAD_MAX_SIZE + IFACE_TAG_SIZE) {
         LOG_ERR("bad resp payload length %d", resp->payload_len);
+        atomic_inc(&iface_stats[IFACE_IDX_USB].errors);
     }
+    usb_xfer_t x = { .buf = resp, .len = IFACE_RESP_HDR_SIZE + resp->payload_len };
     iface_resp_to_le(resp);
-    size_t expect_len = IFACE_RESP_HDR_SIZE + resp->payload_len;
-    int len = usb_transfer_sync(ep_cfg[1].ep_addr, (uint8_t*) resp,
-                                expect_len, USB_TRANS_WRITE);
-    if (len < 0 || len != expect_len) {
-        LOG_ERR("failed to send response %d", len);
-    }
+    k_msgq_put(&tx_queued, &x, K_NO_WAIT);
+    post_tx();
 }
 
 const struct iface_api_t usb_iface_api = {
     .init = usb_init,
     .get_req = usb_get_req,
+    .free_req = usb_free_req,
+    .alloc_resp = usb_alloc_resp,
     .send_resp = usb_send_resp,
     .name = "USB"
 };
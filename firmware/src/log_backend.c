@@ -0,0 +1,105 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log_backend.h>
+#include <zephyr/logging/log_output.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <jabi.h>
+
+#ifdef CONFIG_JABI_LOG_BACKEND
+
+/* Log backend keeping formatted messages for the host to drain through
+ * metadata, boards in the field don't expose a console. Runs in the deferred
+ * log thread, so formatting stays off the request path. Messages are staged
+ * so only whole ones land in the ring, and past CONFIG_JABI_LOG_RATE bytes/s
+ * they're dropped and counted instead of pushing out the history.
+ */
+#define LOG_FLAGS (LOG_OUTPUT_FLAG_LEVEL | LOG_OUTPUT_FLAG_TIMESTAMP | \
+                   LOG_OUTPUT_FLAG_FORMAT_TIMESTAMP)
+
+RING_BUF_DECLARE(log_ring, CONFIG_JABI_LOG_BUFFER_SIZE);
+static struct k_spinlock log_lock; // host reads from an interface thread
+
+static uint8_t log_line[CONFIG_JABI_LOG_LINE_SIZE];
+static size_t log_line_len;
+
+static uint32_t log_dropped; // since the last marker
+static uint32_t log_tokens = CONFIG_JABI_LOG_BUFFER_SIZE;
+static int64_t log_tokens_time;
+
+static int log_char_out(uint8_t *data, size_t length, void *ctx) {
+    size_t n = MIN(length, sizeof(log_line) - log_line_len);
+    memcpy(&log_line[log_line_len], data, n);
+    log_line_len += n;
+    return length; // rest of a long message is truncated
+}
+
+static uint8_t log_output_buf[32];
+LOG_OUTPUT_DEFINE(log_output_jabi, log_char_out, log_output_buf, sizeof(log_output_buf));
+
+static bool log_take_tokens(uint32_t len) {
+    int64_t now = k_uptime_get();
+    uint64_t refill = (now - log_tokens_time) * CONFIG_JABI_LOG_RATE / 1000;
+    if (refill) { // otherwise let the remainder accumulate
+        log_tokens = MIN(CONFIG_JABI_LOG_BUFFER_SIZE, log_tokens + refill);
+        log_tokens_time = now;
+    }
+    if (log_tokens < len) {
+        return false;
+    }
+    log_tokens -= len;
+    return true;
+}
+
+static void log_commit(void) {
+    char marker[40];
+    int marker_len = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&log_lock);
+    if (log_dropped) {
+        marker_len = snprintk(marker, sizeof(marker), "--- %u messages dropped ---\n",
+                              (unsigned int) log_dropped);
+    }
+    uint32_t len = marker_len + log_line_len;
+    if (ring_buf_space_get(&log_ring) < len || !log_take_tokens(len)) {
+        log_dropped++;
+    } else {
+        ring_buf_put(&log_ring, (uint8_t*) marker, marker_len);
+        ring_buf_put(&log_ring, log_line, log_line_len);
+        log_dropped = 0;
+    }
+    k_spin_unlock(&log_lock, key);
+    log_line_len = 0;
+}
+
+static void log_jabi_process(const struct log_backend *const backend, union log_msg_generic *msg) {
+    log_output_msg_process(&log_output_jabi, &msg->log, LOG_FLAGS);
+    log_output_flush(&log_output_jabi);
+    log_commit();
+}
+
+static void log_jabi_dropped(const struct log_backend *const backend, uint32_t cnt) {
+    k_spinlock_key_t key = k_spin_lock(&log_lock);
+    log_dropped += cnt;
+    k_spin_unlock(&log_lock, key);
+}
+
+static void log_jabi_panic(const struct log_backend *const backend) {
+    // nothing to flush, ring keeps whatever made it in
+}
+
+static const struct log_backend_api log_backend_jabi_api = {
+    .process = log_jabi_process,
+    .dropped = log_jabi_dropped,
+    .panic = log_jabi_panic,
+};
+
+LOG_BACKEND_DEFINE(log_backend_jabi, log_backend_jabi_api, true);
+
+size_t jabi_log_read(uint8_t *buf, size_t len) {
+    k_spinlock_key_t key = k_spin_lock(&log_lock);
+    size_t n = ring_buf_get(&log_ring, buf, len);
+    k_spin_unlock(&log_lock, key);
+    return n;
+}
+
+#endif // CONFIG_JABI_LOG_BACKEND
@@ -1,7 +1,9 @@
 #include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/sys/slist.h>
 #include <zephyr/usb/usb_device.h>
 #include <stdlib.h>
+#include <string.h>
 #include <jabi.h>
 
 #include <zephyr/logging/log.h>
@@ -16,16 +18,211 @@ typedef struct {
     sys_snode_t node;
     void* dev;
     struct k_sem lock;
+#if CONFIG_JABI_DISPATCH_WORKERS > 0
+    void *fifo_reserved; // for ready_devs
+    sys_slist_t jobs; // tagged requests in arrival order
+    bool scheduled; // in ready_devs or a worker is running its next job
+#endif // CONFIG_JABI_DISPATCH_WORKERS > 0
 } dev_lock_t;
 
 sys_slist_t dev_locks;
 struct k_sem **peripheral_locks[NUM_PERIPHERALS];
 
+iface_stats_t iface_stats[NUM_INTERFACES];
+struct k_spinlock fn_stats_lock;
+
 K_THREAD_STACK_ARRAY_DEFINE(thread_stack, NUM_INTERFACES, CONFIG_JABI_THREAD_STACK_SIZE);
 struct k_thread thread_data[NUM_INTERFACES];
 
+#if CONFIG_JABI_DISPATCH_WORKERS > 0
+/* Each device queues its own tagged requests, workers take whichever device
+ * is ready next and run one of its jobs. A device is only ever scheduled once,
+ * so its requests still complete in order while others use the free workers.
+ */
+typedef struct {
+    sys_snode_t node;
+    int iface_idx;
+    uint16_t tag;
+    iface_req_t *req; // borrowed from the interface until done
+} dispatch_job_t;
+
+K_MEM_SLAB_DEFINE(dispatch_jobs, sizeof(dispatch_job_t), CONFIG_JABI_DISPATCH_JOBS, sizeof(void*));
+
+K_THREAD_STACK_ARRAY_DEFINE(worker_stack, CONFIG_JABI_DISPATCH_WORKERS, CONFIG_JABI_WORKER_STACK_SIZE);
+struct k_thread worker_data[CONFIG_JABI_DISPATCH_WORKERS];
+K_FIFO_DEFINE(ready_devs);
+struct k_spinlock jobs_lock; // dev_lock_t jobs and scheduled
+// slow jobs run into these, pool buffers are only taken once there's a response to send
+iface_resp_t worker_resp[CONFIG_JABI_DISPATCH_WORKERS];
+#endif // CONFIG_JABI_DISPATCH_WORKERS > 0
+
+periph_stats_t *periph_stats(uint16_t periph_id, uint16_t idx) {
+    return &peripherals[periph_id]->stats[idx];
+}
+
+void periph_fn_stats(uint16_t periph_id, uint16_t fn, periph_fn_stats_t *stats) {
+    k_spinlock_key_t key = k_spin_lock(&fn_stats_lock);
+    *stats = peripherals[periph_id]->fn_stats[fn];
+    k_spin_unlock(&fn_stats_lock, key);
+}
+
+uint64_t jabi_time_us(void) {
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+    return k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+    // extend the 32 bit cycle counter, uptime is coarse but catches any wraps
+    static struct k_spinlock lock;
+    static uint64_t cycles;
+    static uint32_t last_cycles;
+    static int64_t last_ticks;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint32_t now = k_cycle_get_32();
+    int64_t ticks = k_uptime_ticks();
+    uint32_t delta = now - last_cycles;
+    uint64_t elapsed = k_ticks_to_cyc_floor64(ticks - last_ticks);
+    if (elapsed > delta) {
+        cycles += (elapsed - delta + BIT64(31)) & ~(BIT64(32) - 1); // whole wraps missed
+    }
+    cycles += delta;
+    last_cycles = now;
+    last_ticks = ticks;
+    k_spin_unlock(&lock, key);
+    return k_cyc_to_us_floor64(cycles);
+#endif // CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+}
+
+static int16_t check_req(const char *name, iface_req_t *req) {
+    if (req->payload_len > REQ_PAYLOAD_MAX_SIZE) { // only tagged requests get the extra room
+        LOG_ERR("%s payload too long %d", name, req->payload_len);
+        return JABI_INVALID_ARGS_FORMAT_ERR;
+    }
+
+    if (req->periph_id >= NUM_PERIPHERALS) {
+        LOG_ERR("%s invalid peripheral id %d", name, req->periph_id);
+        return JABI_NOT_SUPPORTED_ERR;
+    }
+
+    const struct periph_api_t *api = peripherals[req->periph_id];
+
+    if (req->periph_idx >= api->num_idx) {
+        LOG_ERR("%s invalid peripheral index %d", name, req->periph_idx);
+        return JABI_NOT_SUPPORTED_ERR;
+    }
+
+    if (req->periph_fn >= api->num_fns) {
+        LOG_ERR("%s invalid peripheral function id %d", name, req->periph_fn);
+        return JABI_NOT_SUPPORTED_ERR;
+    }
+    return JABI_NO_ERR;
+}
+
+static void run_req(const char *name, iface_req_t *req, iface_resp_t *resp) {
+    const struct periph_api_t *api = peripherals[req->periph_id];
+    uint16_t payload_len = 0;
+
+    struct k_sem *lock = peripheral_locks[req->periph_id][req->periph_idx];
+    if (k_sem_take(lock, LOCK_TIMEOUT)) {
+        LOG_ERR("%s failed to acquire lock for %d %d",
+            name, req->periph_id, req->periph_idx);
+        resp->retcode = JABI_BUSY_ERR;
+        resp->payload_len = 0;
+        atomic_inc(&periph_stats(req->periph_id, req->periph_idx)->busy);
+        return;
+    }
+    uint32_t start = k_cycle_get_32();
+    resp->retcode = api->fns[req->periph_fn](req->periph_idx,
+                                             req->payload, req->payload_len,
+                                             resp->payload, &payload_len);
+    uint32_t cycles = k_cycle_get_32() - start;
+    k_sem_give(lock);
+
+    k_spinlock_key_t key = k_spin_lock(&fn_stats_lock);
+    api->fn_stats[req->periph_fn].calls++;
+    api->fn_stats[req->periph_fn].cycles += cycles;
+    k_spin_unlock(&fn_stats_lock, key);
+    if (resp->retcode == JABI_BUSY_ERR) {
+        atomic_inc(&periph_stats(req->periph_id, req->periph_idx)->busy);
+    }
+
+    if (resp->retcode) {
+        LOG_ERR("%s peripheral function error %d", name, resp->retcode);
+        payload_len = 0;
+    }
+    resp->payload_len = payload_len;
+}
+
+static void tag_resp(iface_resp_t *resp, uint16_t tag) {
+    sys_put_le16(tag, &resp->payload[resp->payload_len]); // room past the max payload
+    resp->payload_len += IFACE_TAG_SIZE;
+}
+
+static void send_resp(int iface_idx, iface_resp_t *resp) {
+    atomic_add(&iface_stats[iface_idx].tx_bytes, IFACE_RESP_HDR_SIZE + resp->payload_len);
+    if (resp->retcode) {
+        atomic_inc(&iface_stats[iface_idx].errors);
+    }
+    interfaces[iface_idx]->send_resp(resp);
+}
+
+#if CONFIG_JABI_DISPATCH_WORKERS > 0
+void process_jobs(void* p1, void* p2, void* p3) {
+    iface_resp_t *scratch = (iface_resp_t*) p1;
+
+    while (1) {
+        dev_lock_t *d = CONTAINER_OF(k_fifo_get(&ready_devs, K_FOREVER), dev_lock_t, fifo_reserved);
+        k_spinlock_key_t key = k_spin_lock(&jobs_lock);
+        dispatch_job_t *job = CONTAINER_OF(sys_slist_get(&d->jobs), dispatch_job_t, node);
+        k_spin_unlock(&jobs_lock, key);
+
+        const struct iface_api_t *iface = interfaces[job->iface_idx];
+        run_req(iface->name, job->req, scratch);
+        iface->free_req(job->req);
+        tag_resp(scratch, job->tag);
+
+        iface_resp_t *resp = iface->alloc_resp();
+        memcpy(resp, scratch, IFACE_RESP_HDR_SIZE + scratch->payload_len);
+        send_resp(job->iface_idx, resp);
+        k_mem_slab_free(&dispatch_jobs, job);
+
+        // back of the line w/ the rest, one busy device doesn't hog a worker
+        key = k_spin_lock(&jobs_lock);
+        bool more = !sys_slist_is_empty(&d->jobs);
+        d->scheduled = more;
+        k_spin_unlock(&jobs_lock, key);
+        if (more) {
+            k_fifo_put(&ready_devs, &d->fifo_reserved);
+        }
+    }
+}
+
+static bool dispatch_req(int iface_idx, iface_req_t *req, uint16_t tag) {
+    dispatch_job_t *job;
+    if (k_mem_slab_alloc(&dispatch_jobs, (void**) &job, LOCK_TIMEOUT)) {
+        LOG_ERR("%s no free jobs for tag %d", interfaces[iface_idx]->name, tag);
+        return false;
+    }
+    job->iface_idx = iface_idx;
+    job->tag = tag;
+    job->req = req;
+
+    struct k_sem *lock = peripheral_locks[req->periph_id][req->periph_idx];
+    dev_lock_t *d = CONTAINER_OF(lock, dev_lock_t, lock);
+    k_spinlock_key_t key = k_spin_lock(&jobs_lock);
+    sys_slist_append(&d->jobs, &job->node);
+    bool schedule = !d->scheduled;
+    d->scheduled = true;
+    k_spin_unlock(&jobs_lock, key);
+    if (schedule) {
+        k_fifo_put(&ready_devs, &d->fifo_reserved);
+    }
+    return true;
+}
+#endif // CONFIG_JABI_DISPATCH_WORKERS > 0
+
 void process_interface(void* p1, void* p2, void* p3) {
-    const struct iface_api_t *iface = (const struct iface_api_t*) p1;
+    int iface_idx = (int) (uintptr_t) p1;
+    const struct iface_api_t *iface = interfaces[iface_idx];
     
     if (iface->init()) {
         LOG_ERR("failed to start interface %s", iface->name);
@@ -33,56 +230,53 @@ void process_interface(void* p1, void* p2, void* p3) {
     }
     LOG_INF("started processing interface %s", iface->name);
 
-    iface_req_t req;
-    iface_resp_t resp;
     while (1) {
         /* CPU endianness assumed for non-payload members */
-        iface->get_req(&req);
+        iface_req_t *req = iface->get_req();
+        atomic_add(&iface_stats[iface_idx].rx_bytes, IFACE_REQ_HDR_SIZE + req->payload_len);
         LOG_DBG("%s recvd msg id: %d idx: %d fn: %d",
-                iface->name, req.periph_id, req.periph_idx, req.periph_fn);
+                iface->name, req->periph_id, req->periph_idx, req->periph_fn);
 
-        uint16_t payload_len = 0;
-
-        if (req.periph_id >= NUM_PERIPHERALS) {
-            LOG_ERR("%s invalid peripheral id %d", iface->name, req.periph_id);
-            resp.retcode = JABI_NOT_SUPPORTED_ERR;
-            goto send_resp;
+        bool tagged = req->periph_fn & IFACE_FN_TAGGED;
+        uint16_t tag = 0;
+        if (tagged) {
+            req->periph_fn &= ~IFACE_FN_TAGGED;
+            if (req->payload_len < IFACE_TAG_SIZE) {
+                LOG_ERR("%s tagged request missing tag", iface->name);
+                iface->free_req(req);
+                iface_resp_t *resp = iface->alloc_resp();
+                resp->retcode = JABI_INVALID_ARGS_FORMAT_ERR;
+                resp->payload_len = 0;
+                send_resp(iface_idx, resp);
+                continue;
+            }
+            req->payload_len -= IFACE_TAG_SIZE;
+            tag = sys_get_le16(&req->payload[req->payload_len]);
         }
 
-        const struct periph_api_t *api = peripherals[req.periph_id];
-
-        if (req.periph_idx >= api->num_idx) {
-            LOG_ERR("%s invalid peripheral index %d", iface->name, req.periph_idx);
-            resp.retcode = JABI_NOT_SUPPORTED_ERR;
-            goto send_resp;
+        int16_t retcode = check_req(iface->name, req);
+#if CONFIG_JABI_DISPATCH_WORKERS > 0
+        if (!retcode && tagged) {
+            if (dispatch_req(iface_idx, req, tag)) {
+                continue; // worker responds and frees req
+            }
+            retcode = JABI_BUSY_ERR;
         }
+#endif // CONFIG_JABI_DISPATCH_WORKERS > 0
 
-        if (req.periph_fn >= api->num_fns) {
-            LOG_ERR("%s invalid peripheral function id %d", iface->name, req.periph_fn);
-            resp.retcode = JABI_NOT_SUPPORTED_ERR;
-            goto send_resp;
+        iface_resp_t *resp = iface->alloc_resp();
+        if (retcode) {
+            resp->retcode = retcode;
+            resp->payload_len = 0;
+        } else {
+            run_req(iface->name, req, resp);
         }
+        iface->free_req(req);
 
-        struct k_sem *lock = peripheral_locks[req.periph_id][req.periph_idx];
-        if (k_sem_take(lock, LOCK_TIMEOUT)) {
-            LOG_ERR("%s failed to acquire lock for %d %d",
-                iface->name, req.periph_id, req.periph_idx);
-            resp.retcode = JABI_BUSY_ERR;
-            goto send_resp;
+        if (tagged) {
+            tag_resp(resp, tag);
         }
-        resp.retcode = api->fns[req.periph_fn](req.periph_idx, 
-                                               req.payload, req.payload_len,
-                                               resp.payload, &payload_len);
-        k_sem_give(lock);
-
-        if (resp.retcode) {
-            LOG_ERR("%s peripheral function error %d", iface->name, resp.retcode);
-            payload_len = 0;
-        }
-
-send_resp:
-        resp.payload_len = payload_len;
-        iface->send_resp(&resp);
+        send_resp(iface_idx, resp);
     }
 }
 
@@ -119,6 +313,10 @@ int main() {
                 }
                 d->dev = peripherals[i]->get_dev(j);
                 k_sem_init(&d->lock, 1, 1);
+#if CONFIG_JABI_DISPATCH_WORKERS > 0
+                sys_slist_init(&d->jobs);
+                d->scheduled = false;
+#endif // CONFIG_JABI_DISPATCH_WORKERS > 0
                 peripheral_locks[i][j] = &d->lock;
                 sys_slist_prepend(&dev_locks, &d->node);
             }
@@ -130,9 +328,17 @@ int main() {
         }
     }
 
+#if CONFIG_JABI_DISPATCH_WORKERS > 0
+    for (int i = 0; i < CONFIG_JABI_DISPATCH_WORKERS; i++) {
+        k_thread_create(&worker_data[i], worker_stack[i], CONFIG_JABI_WORKER_STACK_SIZE,
+                        process_jobs, &worker_resp[i], NULL, NULL,
+                        K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+    }
+#endif // CONFIG_JABI_DISPATCH_WORKERS > 0
+
     for (int i = 0; i < NUM_INTERFACES; i++) {
         k_thread_create(&thread_data[i], thread_stack[i], CONFIG_JABI_THREAD_STACK_SIZE,
-                        process_interface, (void*) interfaces[i], NULL, NULL,
+                        process_interface, (void*) (uintptr_t) i, NULL, NULL,
                         K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
     }
     return 0;
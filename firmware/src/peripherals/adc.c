@@ -81,6 +81,9 @@ static const periph_func_t adc_periph_fns[] = {
     adc_read_j,
 };
 
+static periph_stats_t adc_stats[ARRAY_SIZE(adc_devs)];
+static periph_fn_stats_t adc_fn_stats[ARRAY_SIZE(adc_periph_fns)];
+
 const struct periph_api_t adc_periph_api = {
     .init = adc_init,
     .get_dev = adc_get_dev,
@@ -88,6 +91,8 @@ const struct periph_api_t adc_periph_api = {
     .num_fns = ARRAY_SIZE(adc_periph_fns),
     .num_idx = ARRAY_SIZE(adc_devs),
     .name = "adc",
+    .stats = adc_stats,
+    .fn_stats = adc_fn_stats,
 };
 
 #else
@@ -1,5 +1,9 @@
 #include <zephyr/drivers/can.h>
+#ifdef CONFIG_ISOTP
+#include <zephyr/canbus/isotp.h>
+#endif // CONFIG_ISOTP
 #include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
 #include <jabi.h>
 #include <jabi/peripherals/can.h>
 
@@ -15,47 +19,648 @@ LOG_MODULE_REGISTER(periph_can, CONFIG_LOG_DEFAULT_LEVEL);
 #endif // CONFIG_CAN_FD_MODE
 
 #define SEND_TIMEOUT K_MSEC(500) // smaller than libjabi timeout
+#define SLOT_RETRY   K_MSEC(1)   // tx mailboxes full, e.g. ISO-TP holding them
+#define STATS_WINDOW_MS 1000     // rates and bus load are over this
+#define ISOTP_WAIT_MS   1000     // longest a function blocks on ISO-TP, below libjabi timeout
+
+// initial bitrates for bus load, renamed from bus-speed in newer Zephyr
+#define GEN_DT_BITRATE(node, suffix, default) \
+    DT_PROP_OR(node, bitrate##suffix, DT_PROP_OR(node, bus_speed##suffix, default))
+
+/* Host filters and gateway routes are matched in software from one callback,
+ * the controller's filters only narrow down what reaches it. Those never overlap, so a driver
+ * calling back just the first match (FlexCAN, MCAN) or every match (loopback)
+ * delivers a frame once. Overlapping filters, and any past what the controller
+ * has room for, share one merged filter covering all of them, the rest each
+ * keep their own.
+ */
+typedef struct {
+    struct can_filter filter;
+    int16_t entry; // filter (route past CONFIG_JABI_CAN_FILTERS) it covers exactly, negative if merged
+    uint16_t dev;
+    int id; // from can_add_rx_filter, negative if not added
+} can_hw_filter_t;
+
+/* Received frames are packed back to back as a header then only the payload
+ * bytes actually sent, so classic frames don't take up a whole can_frame.
+ * Timestamps only go in once the host has read w/ them, until then a classic
+ * frame is 6 + 8 bytes.
+ */
+#define RX_HDR_TS BIT(7) // in flags, can_rx_ts_t follows the header
+
+BUILD_ASSERT(!((CAN_FRAME_IDE | CAN_FRAME_RTR | CAN_FRAME_FDF | CAN_FRAME_BRS | CAN_FRAME_ESI) &
+    RX_HDR_TS));
+
+typedef struct {
+    uint32_t id;
+    uint8_t flags; // CAN_FRAME_*
+    uint8_t dlc;
+} __packed can_rx_hdr_t;
+
+typedef struct {
+    uint64_t timestamp;    // us since boot, taken in the rx callback
+    uint16_t hw_timestamp; // CONFIG_CAN_RX_TIMESTAMP only
+} __packed can_rx_ts_t;
+
+// metadata sizes the rx arena partition w/ this
+BUILD_ASSERT(sizeof(can_rx_hdr_t) + sizeof(can_rx_ts_t) + CAN_MAX_DLEN == CAN_RX_ITEM_SIZE);
+
+/* Bus statistics are counted in the rx/tx callbacks. Received frames are
+ * counted before matching, so they cover every frame the controller's filters
+ * let in, which is all of them unless a filter or route narrows an id type.
+ * Rates are taken from these once per window.
+ */
+enum {
+    BUS_RX_FRAMES,
+    BUS_RX_BYTES,
+    BUS_TX_FRAMES,
+    BUS_TX_BYTES,
+    BUS_TIME_NS, // frames w/o bit stuffing, wraps
+    BUS_NUM_COUNTS,
+};
 
 typedef struct {
+    uint32_t key; // id, BIT(31) if extended
+    uint32_t count;
+} can_top_id_t;
+
+/* Cyclic frames are timed off jabi_time_us() by a one shot timer re-armed for
+ * the earliest due slot, then go through the tx queue like any other frame.
+ */
+enum {
+    CHECKSUM_NONE,
+    CHECKSUM_XOR,
+    CHECKSUM_SUM,
+    CHECKSUM_CRC8_SAE_J1850,
+};
+
+typedef struct {
+    struct can_frame frame;
+    uint32_t period_us; // 0 if unused
+    uint64_t due;
+    uint8_t counter_byte;
+    uint8_t counter_bits;
+    uint8_t counter;
+    uint8_t checksum_byte;
+    uint8_t checksum_type;
+    uint32_t sent;
+    uint32_t missed;
+} can_cyclic_t;
+
+/* Gateway routes match in the shared rx callback, which forwards from ISR
+ * context w/o going through the rx queue or the host.
+ */
+typedef struct {
+    bool active;
     struct can_filter filter;
-    int id;
-} can_filter_data_t;
+    uint16_t dst;
+    uint32_t rewrite_mask;
+    uint32_t new_id;
+    atomic_t forwarded;
+    atomic_t dropped;
+} can_route_t;
+
+#ifdef CONFIG_ISOTP
+/* ISO-TP runs in Zephyr's subsystem, which answers flow control and paces
+ * consecutive frames itself. It adds its own controller filter for rx_id
+ * (also flow control for sends), which a first-match controller would starve
+ * if one of ours covered it. So binding is refused while a filter or route
+ * covers rx_id, and so are filters and routes covering it while bound.
+ */
+typedef struct {
+    bool bound;
+    struct can_filter rx_filter;
+    struct isotp_msg_id tx_addr;
+    struct isotp_msg_id rx_addr;
+    struct isotp_recv_ctx recv_ctx;
+    struct isotp_send_ctx send_ctx;
+
+    uint8_t tx_buf[CONFIG_JABI_CAN_ISOTP_SIZE]; // referenced until sent
+    uint16_t tx_staged;
+    atomic_t tx_busy;
+    int tx_err;
+    struct k_sem tx_done;
+
+    struct net_buf *rx_buf; // fragments not yet returned
+    uint16_t rx_total; // 0 if no PDU in progress
+    uint16_t rx_offset;
+    int rx_rem; // still in the subsystem
+} can_isotp_data_t;
+#endif // CONFIG_ISOTP
 
 typedef struct {
     const struct device *dev;
-    can_filter_data_t filter_std;
-    can_filter_data_t filter_ext;
-    struct k_msgq *msgq;
-    struct k_sem tx_lock;
-    bool tx_was_busy;
-} can_dev_data_t;
+    struct can_filter filters[CONFIG_JABI_CAN_FILTERS];
+    uint8_t num_filters;
+    can_hw_filter_t hw[CONFIG_JABI_CAN_FILTERS + CONFIG_JABI_CAN_ROUTES];
+    uint16_t num_hw;
+    struct ring_buf rx; // buffer is a slice of the rx arena
+    struct k_spinlock rx_lock; // producers, filters may call back from separate FIFO IRQs
+    atomic_t rx_count;
+    atomic_t rx_dropped;
+    atomic_t rx_ts; // set by the first timestamped read
+
+    /* Frames go out one at a time through the queue so they leave in order,
+     * controllers w/ several mailboxes may otherwise send by priority.
+     */
+    struct k_msgq tx_queue;
+    struct k_spinlock tx_queue_lock; // queued count matches queue order
+    char __aligned(4) tx_queue_buf[CONFIG_JABI_CAN_TX_QUEUE_SIZE * sizeof(struct can_frame)];
+    struct k_work_delayable tx_work;
+    atomic_t tx_busy; // frame in flight or held
+    bool tx_held; // tx_frame waiting on a free mailbox, only touched by tx_work
+    struct can_frame tx_frame;
+    atomic_t tx_queued; // counters since boot
+    atomic_t tx_sent;
+    atomic_t tx_failed;
+    uint32_t tx_watch; // sequence number (tx_queued count) of the frame can_write waits on
+    int tx_watch_err;
+    struct k_sem tx_lock; // given on every completion
+
+    uint32_t ns_per_bit; // for bus load
+    uint32_t ns_per_bit_data;
+    atomic_t bus[BUS_NUM_COUNTS]; // since boot
+    uint32_t bus_prev[BUS_NUM_COUNTS];
+    uint32_t bus_rate[BUS_NUM_COUNTS]; // per second, last window
+    atomic_t error_warning; // state changes into each
+    atomic_t error_passive;
+    atomic_t bus_off;
+    struct k_spinlock top_lock;
+    can_top_id_t top[CONFIG_JABI_CAN_TOP_IDS];
 
-#define GEN_CAN_MSGQ(node_id, prop, idx) \
-    CAN_MSGQ_DEFINE(can_msgq##idx, CONFIG_JABI_CAN_BUFFER_SIZE);
+    struct k_timer cyclic_timer;
+    struct k_spinlock cyclic_lock; // timer runs in ISR context
+    can_cyclic_t cyclic[CONFIG_JABI_CAN_CYCLIC_SLOTS];
+
+    can_route_t routes[CONFIG_JABI_CAN_ROUTES];
+
+#ifdef CONFIG_ISOTP
+    can_isotp_data_t isotp;
+#endif // CONFIG_ISOTP
+} can_dev_data_t;
 
 #define GEN_CAN_DEV_DATA(node_id, prop, idx)                                             \
     {                                                                                    \
         .dev = DEVICE_DT_GET(DT_PROP_BY_IDX(node_id, prop, idx)),                        \
-        .filter_std.filter = {                                                           \
-            .id = 0,                                                                     \
-            .mask = 0,                                                                   \
-            .flags = 0,                                                                  \
-        },                                                                               \
-        .filter_ext.filter = {                                                           \
-            .id = 0,                                                                     \
-            .mask = 0,                                                                   \
-            .flags = CAN_FILTER_IDE,                                                     \
-        },                                                                               \
-        .msgq = &can_msgq##idx,                                                          \
-        .tx_was_busy = false,                                                            \
+        .ns_per_bit = NSEC_PER_SEC /                                                     \
+            GEN_DT_BITRATE(DT_PROP_BY_IDX(node_id, prop, idx), , 125000),                \
+        .ns_per_bit_data = NSEC_PER_SEC /                                                \
+            GEN_DT_BITRATE(DT_PROP_BY_IDX(node_id, prop, idx), _data, 1000000),          \
     },
 
-DT_FOREACH_PROP_ELEM(JABI_PERIPH_NODE, can, GEN_CAN_MSGQ);
-
 static can_dev_data_t can_devs[] = {
     DT_FOREACH_PROP_ELEM(JABI_PERIPH_NODE, can, GEN_CAN_DEV_DATA)
 };
 
+static uint32_t can_frame_ns(can_dev_data_t *can, uint8_t flags, uint8_t len) {
+    bool ext = (flags & CAN_FRAME_IDE) != 0;
+    if (!(flags & CAN_FRAME_FDF)) {
+        return ((ext ? 67 : 47) + 8 * len) * can->ns_per_bit;
+    }
+    // arbitration and ack/eof/ifs at the nominal rate, the rest maybe switched
+    uint32_t data_bits = 8 * len + (len > 16 ? 21 : 17) + 10;
+    uint32_t data_ns = data_bits * ((flags & CAN_FRAME_BRS) ? can->ns_per_bit_data : can->ns_per_bit);
+    return ((ext ? 41 : 22) + 12) * can->ns_per_bit + data_ns;
+}
+
+static void can_bus_count(can_dev_data_t *can, bool tx, uint8_t flags, uint8_t len) {
+    atomic_inc(&can->bus[tx ? BUS_TX_FRAMES : BUS_RX_FRAMES]);
+    atomic_add(&can->bus[tx ? BUS_TX_BYTES : BUS_RX_BYTES], len);
+    atomic_add(&can->bus[BUS_TIME_NS], can_frame_ns(can, flags, len));
+}
+
+static void can_top_ids_add(can_dev_data_t *can, uint32_t key) {
+    // space saving, a new id takes over the rarest slot and inherits its count
+    k_spinlock_key_t lock = k_spin_lock(&can->top_lock);
+    can_top_id_t *min = &can->top[0];
+    bool found = false;
+    for (int i = 0; i < CONFIG_JABI_CAN_TOP_IDS && !found; i++) {
+        if (can->top[i].count && can->top[i].key == key) {
+            can->top[i].count++;
+            found = true;
+        } else if (can->top[i].count < min->count) {
+            min = &can->top[i];
+        }
+    }
+    if (!found) {
+        min->key = key;
+        min->count++;
+    }
+    k_spin_unlock(&can->top_lock, lock);
+}
+
+static void can_stats_work(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(can_stats_dwork, can_stats_work);
+static int64_t can_stats_time;
+
+static void can_stats_work(struct k_work *work) {
+    int64_t now = k_uptime_get();
+    uint32_t dt = now - can_stats_time;
+    can_stats_time = now;
+    for (int i = 0; i < ARRAY_SIZE(can_devs) && dt; i++) {
+        can_dev_data_t *can = &can_devs[i];
+        for (int j = 0; j < BUS_NUM_COUNTS; j++) {
+            uint32_t cur = atomic_get(&can->bus[j]);
+            can->bus_rate[j] = (uint64_t) (cur - can->bus_prev[j]) * MSEC_PER_SEC / dt;
+            can->bus_prev[j] = cur;
+        }
+    }
+    k_work_schedule(&can_stats_dwork, K_MSEC(STATS_WINDOW_MS));
+}
+
+static void can_state_cb(const struct device *dev, enum can_state state,
+                         struct can_bus_err_cnt err_cnt, void *user_data) {
+    can_dev_data_t *can = user_data;
+    switch (state) {
+        case CAN_STATE_ERROR_WARNING: atomic_inc(&can->error_warning); break;
+        case CAN_STATE_ERROR_PASSIVE: atomic_inc(&can->error_passive); break;
+        case CAN_STATE_BUS_OFF:       atomic_inc(&can->bus_off);       break;
+        default: break;
+    }
+}
+
+static void can_rx_queue(can_dev_data_t *can, const struct can_frame *frame, uint64_t timestamp) {
+    uint8_t record[CAN_RX_ITEM_SIZE];
+    can_rx_hdr_t *hdr = (can_rx_hdr_t*) record;
+    uint32_t len = sizeof(can_rx_hdr_t);
+    hdr->id = frame->id;
+    hdr->flags = frame->flags;
+    hdr->dlc = frame->dlc;
+    if (atomic_get(&can->rx_ts)) {
+        can_rx_ts_t *ts = (can_rx_ts_t*) &record[len];
+        ts->timestamp = timestamp;
+#ifdef CONFIG_CAN_RX_TIMESTAMP
+        ts->hw_timestamp = frame->timestamp;
+#else
+        ts->hw_timestamp = 0;
+#endif // CONFIG_CAN_RX_TIMESTAMP
+        hdr->flags |= RX_HDR_TS;
+        len += sizeof(can_rx_ts_t);
+    }
+    uint8_t data_len = (frame->flags & CAN_FRAME_RTR) ? 0 : can_dlc_to_bytes(frame->dlc);
+    memcpy(&record[len], frame->data, data_len);
+    len += data_len;
+
+    // whole record or nothing, consumer only sees it once all of it is in
+    periph_stats_t *stats = periph_stats(PERIPH_CAN_ID, can - can_devs);
+    k_spinlock_key_t key = k_spin_lock(&can->rx_lock);
+    bool dropped = ring_buf_space_get(&can->rx) < len;
+    if (!dropped) {
+        ring_buf_put(&can->rx, record, len);
+    }
+    uint32_t used = ring_buf_size_get(&can->rx);
+    k_spin_unlock(&can->rx_lock, key);
+
+    if (dropped) {
+        atomic_inc(&can->rx_dropped);
+    } else {
+        atomic_inc(&can->rx_count);
+    }
+    periph_stats_rx(stats, 1, dropped, used);
+}
+
+static bool can_filter_match(const struct can_filter *f, const struct can_frame *frame) {
+    uint8_t ide = (frame->flags & CAN_FRAME_IDE) ? CAN_FILTER_IDE : 0;
+    return (f->flags & CAN_FILTER_IDE) == ide && ((frame->id ^ f->id) & f->mask) == 0;
+}
+
+static void can_route_forward(can_route_t *r, const struct can_frame *frame);
+
+static void can_rx_cb(const struct device *dev, struct can_frame *frame, void *user_data) {
+    uint64_t timestamp = jabi_time_us(); // first, so the rest of the callback isn't counted
+    can_hw_filter_t *h = user_data;
+    can_dev_data_t *can = &can_devs[h->dev];
+    // everything the controller lets in, before routes and host filters narrow it down
+    can_bus_count(can, false, frame->flags, (frame->flags & CAN_FRAME_RTR) ? 0 : can_dlc_to_bytes(frame->dlc));
+    can_top_ids_add(can, frame->id | ((frame->flags & CAN_FRAME_IDE) ? BIT(31) : 0));
+
+    if (h->entry >= CONFIG_JABI_CAN_FILTERS) {
+        can_route_forward(&can->routes[h->entry - CONFIG_JABI_CAN_FILTERS], frame);
+        return;
+    }
+    for (int i = 0; i < CONFIG_JABI_CAN_ROUTES && h->entry < 0; i++) {
+        if (can->routes[i].active && can_filter_match(&can->routes[i].filter, frame)) {
+            can_route_forward(&can->routes[i], frame);
+        }
+    }
+    bool match = h->entry >= 0;
+    for (int i = 0; i < can->num_filters && !match; i++) {
+        match = can_filter_match(&can->filters[i], frame);
+    }
+    if (match) {
+        can_rx_queue(can, frame, timestamp);
+    }
+}
+
+// true if some frame matches both
+static bool can_filters_overlap(const struct can_filter *a, const struct can_filter *b) {
+    return (a->flags & CAN_FILTER_IDE) == (b->flags & CAN_FILTER_IDE) &&
+        ((a->id ^ b->id) & a->mask & b->mask) == 0;
+}
+
+// narrowest filter matching everything either does
+static void can_filters_merge(struct can_filter *a, const struct can_filter *b) {
+    a->mask &= b->mask & ~(a->id ^ b->id);
+    a->id &= a->mask;
+}
+
+// true if f would take frames the bound ISO-TP context waits for
+static bool can_isotp_shadowed(can_dev_data_t *can, const struct can_filter *f) {
+#ifdef CONFIG_ISOTP
+    return can->isotp.bound && can_filters_overlap(&can->isotp.rx_filter, f);
+#else
+    return false;
+#endif // CONFIG_ISOTP
+}
+
+// nothing calls back into the tables once this returns
+static void can_hw_remove(can_dev_data_t *can) {
+    for (int i = 0; i < can->num_hw; i++) {
+        if (can->hw[i].id >= 0) {
+            can_remove_rx_filter(can->dev, can->hw[i].id);
+            can->hw[i].id = -ENODEV;
+        }
+    }
+}
+
+static void can_hw_merge(can_dev_data_t *can, int i, int j) {
+    can_filters_merge(&can->hw[i].filter, &can->hw[j].filter);
+    can->hw[i].entry = -1;
+    can->hw[j] = can->hw[--can->num_hw];
+}
+
+// merge until no two overlap
+static void can_hw_resolve(can_dev_data_t *can) {
+    for (int i = 0; i < can->num_hw; i++) {
+        for (int j = i + 1; j < can->num_hw; j++) {
+            if (can_filters_overlap(&can->hw[i].filter, &can->hw[j].filter)) {
+                can_hw_merge(can, i, j);
+                i = -1; // merged filter may now overlap ones already checked
+                break;
+            }
+        }
+    }
+}
+
+static int can_hw_count(can_dev_data_t *can, uint8_t flags) {
+    int num = 0;
+    for (int i = 0; i < can->num_hw; i++) {
+        num += (can->hw[i].filter.flags & CAN_FILTER_IDE) == flags;
+    }
+    return num;
+}
+
+// one less filter of the id type, merging the pair that stays the most specific
+static bool can_hw_shrink(can_dev_data_t *can, uint8_t flags) {
+    int best_i = -1, best_j = -1, best_bits = -1;
+    for (int i = 0; i < can->num_hw; i++) {
+        if ((can->hw[i].filter.flags & CAN_FILTER_IDE) != flags) {
+            continue;
+        }
+        for (int j = i + 1; j < can->num_hw; j++) {
+            if ((can->hw[j].filter.flags & CAN_FILTER_IDE) != flags) {
+                continue;
+            }
+            struct can_filter m = can->hw[i].filter;
+            can_filters_merge(&m, &can->hw[j].filter);
+            if ((int) POPCOUNT(m.mask) > best_bits) {
+                best_i = i;
+                best_j = j;
+                best_bits = POPCOUNT(m.mask);
+            }
+        }
+    }
+    if (best_i < 0) {
+        return false;
+    }
+    can_hw_merge(can, best_i, best_j);
+    can_hw_resolve(can);
+    return true;
+}
+
+// filters[0..num_filters) and routes filled in, returns how many filters have one of their own
+static int can_filters_install(can_dev_data_t *can) {
+    can_hw_remove(can);
+    can->num_hw = 0;
+    for (int i = 0; i < can->num_filters; i++) {
+        can->hw[can->num_hw++] = (can_hw_filter_t) {
+            .filter = can->filters[i], .entry = i, .dev = can - can_devs, .id = -ENODEV,
+        };
+    }
+    for (int i = 0; i < CONFIG_JABI_CAN_ROUTES; i++) {
+        if (can->routes[i].active) {
+            can->hw[can->num_hw++] = (can_hw_filter_t) {
+                .filter = can->routes[i].filter, .entry = CONFIG_JABI_CAN_FILTERS + i,
+                .dev = can - can_devs, .id = -ENODEV,
+            };
+        }
+    }
+    can_hw_resolve(can);
+    for (int ext = 0; ext <= 1; ext++) { // other users share the controller, so only a start
+        uint8_t flags = ext ? CAN_FILTER_IDE : 0;
+        int max = can_get_max_filters(can->dev, ext);
+        while (max > 0 && can_hw_count(can, flags) > max && can_hw_shrink(can, flags)) {
+        }
+    }
+
+    while (true) {
+        for (int i = 0; i < can->num_hw; i++) { // merging may have widened one over it
+            if (can_isotp_shadowed(can, &can->hw[i].filter)) {
+                can->num_hw = 0;
+                return -EADDRINUSE;
+            }
+        }
+        int err = 0;
+        uint8_t flags = 0;
+        for (int i = 0; i < can->num_hw && !err; i++) {
+            can_hw_filter_t *h = &can->hw[i];
+            h->id = can_add_rx_filter(can->dev, can_rx_cb, h, &h->filter);
+            err = MIN(h->id, 0);
+            flags = h->filter.flags & CAN_FILTER_IDE;
+        }
+        if (!err) {
+            break;
+        }
+        can_hw_remove(can);
+        if (err != -ENOSPC || !(can_hw_shrink(can, flags) ||
+                can_hw_shrink(can, flags ^ CAN_FILTER_IDE))) {
+            can->num_hw = 0;
+            return err;
+        }
+    }
+
+    int num_own = 0;
+    for (int i = 0; i < can->num_hw; i++) {
+        num_own += can->hw[i].entry >= 0 && can->hw[i].entry < CONFIG_JABI_CAN_FILTERS;
+    }
+    return num_own;
+}
+
+static int can_filters_single(can_dev_data_t *can, uint32_t id, uint32_t mask) {
+    // RTR frames rejected by default, set CONFIG_CAN_ACCEPT_RTR=y to allow
+    can_hw_remove(can);
+    can->num_filters = 0;
+    if (mask <= CAN_STD_ID_MASK) {
+        can->filters[can->num_filters++] = (struct can_filter) {
+            .id = id, .mask = mask, .flags = 0,
+        };
+    }
+    can->filters[can->num_filters++] = (struct can_filter) {
+        .id = id, .mask = mask, .flags = CAN_FILTER_IDE,
+    };
+    return can_filters_install(can);
+}
+
+// one frame is in flight at a time and they leave in queue order, so the
+// completion count is the finished frame's sequence number
+static void can_tx_done(can_dev_data_t *can, int error) {
+    uint32_t seq = atomic_get(&can->tx_sent) + atomic_get(&can->tx_failed) + 1;
+    if (seq == can->tx_watch) { // before counting, can_write reads it once the count is up
+        can->tx_watch_err = error;
+    }
+    if (error) {
+        atomic_inc(&can->tx_failed);
+    } else {
+        atomic_inc(&can->tx_sent);
+    }
+    atomic_clear(&can->tx_busy);
+    k_sem_give(&can->tx_lock);
+}
+
+static void can_tx_cb(const struct device *dev, int error, void *user_data) {
+    can_dev_data_t *can = user_data;
+    if (error) { // shouldn't happen w/ auto recovery
+        LOG_ERR("message send error %d?!", error);
+    } else {
+        const struct can_frame *f = &can->tx_frame; // untouched until the next dequeue
+        can_bus_count(can, true, f->flags, (f->flags & CAN_FRAME_RTR) ? 0 : can_dlc_to_bytes(f->dlc));
+    }
+    can_tx_done(can, error);
+    k_work_schedule(&can->tx_work, K_NO_WAIT);
+}
+
+static void can_tx_work(struct k_work *work) {
+    can_dev_data_t *can = CONTAINER_OF(k_work_delayable_from_work(work), can_dev_data_t, tx_work);
+    // a held frame keeps tx_busy set and goes before anything in the queue
+    while (can->tx_held || atomic_cas(&can->tx_busy, 0, 1)) {
+        if (!can->tx_held && k_msgq_get(&can->tx_queue, &can->tx_frame, K_NO_WAIT)) {
+            atomic_clear(&can->tx_busy); // a racing put resubmits us
+            return;
+        }
+        can->tx_held = false;
+        int err = can_send(can->dev, &can->tx_frame, K_NO_WAIT, can_tx_cb, can);
+        if (err == 0) {
+            return; // callback continues w/ the next frame
+        }
+        if (err == -EAGAIN) { // don't block the workqueue, try again shortly
+            can->tx_held = true;
+            k_work_schedule(&can->tx_work, SLOT_RETRY);
+            return;
+        }
+        LOG_ERR("couldn't send message %d", err);
+        can_tx_done(can, err);
+    }
+}
+
+// returns the frame's sequence number, w/ target its status lands in tx_watch_err
+static int can_tx_enqueue(can_dev_data_t *can, const struct can_frame *frame, uint32_t *target) {
+    k_spinlock_key_t key = k_spin_lock(&can->tx_queue_lock);
+    if (target) { // before the put, the frame can complete right after it
+        can->tx_watch = atomic_get(&can->tx_queued) + 1;
+        can->tx_watch_err = 0;
+    }
+    int err = k_msgq_put(&can->tx_queue, frame, K_NO_WAIT);
+    if (err == 0) {
+        uint32_t queued = atomic_inc(&can->tx_queued) + 1;
+        if (target) {
+            *target = queued;
+        }
+    }
+    k_spin_unlock(&can->tx_queue_lock, key);
+    return err;
+}
+
+static void can_cyclic_fill(can_cyclic_t *c) {
+    uint8_t len = (c->frame.flags & CAN_FRAME_RTR) ? 0 : can_dlc_to_bytes(c->frame.dlc);
+    uint8_t *data = c->frame.data;
+    if (c->counter_bits && c->counter_byte < len) {
+        uint8_t mask = BIT_MASK(c->counter_bits);
+        data[c->counter_byte] = (data[c->counter_byte] & ~mask) | (c->counter & mask);
+        c->counter++;
+    }
+    if (c->checksum_type == CHECKSUM_NONE || c->checksum_byte >= len) {
+        return;
+    }
+    uint8_t sum = c->checksum_type == CHECKSUM_CRC8_SAE_J1850 ? 0xFF : 0;
+    for (int i = 0; i < len; i++) {
+        if (i == c->checksum_byte) {
+            continue;
+        }
+        switch (c->checksum_type) {
+            case CHECKSUM_XOR: sum ^= data[i]; break;
+            case CHECKSUM_SUM: sum += data[i]; break;
+            default:
+                sum ^= data[i];
+                for (int j = 0; j < 8; j++) {
+                    sum = (sum & 0x80) ? (sum << 1) ^ 0x1D : sum << 1;
+                }
+                break;
+        }
+    }
+    data[c->checksum_byte] = c->checksum_type == CHECKSUM_CRC8_SAE_J1850 ? sum ^ 0xFF : sum;
+}
+
+static void can_cyclic_timer(struct k_timer *timer) {
+    can_dev_data_t *can = CONTAINER_OF(timer, can_dev_data_t, cyclic_timer);
+    uint64_t now = jabi_time_us();
+    uint64_t next = UINT64_MAX;
+    bool queued = false;
+
+    k_spinlock_key_t key = k_spin_lock(&can->cyclic_lock);
+    for (int i = 0; i < CONFIG_JABI_CAN_CYCLIC_SLOTS; i++) {
+        can_cyclic_t *c = &can->cyclic[i];
+        if (!c->period_us) {
+            continue;
+        }
+        if (c->due <= now) {
+            can_cyclic_fill(c);
+            if (can_tx_enqueue(can, &c->frame, NULL)) {
+                c->missed++;
+            } else {
+                c->sent++;
+                queued = true;
+            }
+            c->due += c->period_us;
+            if (c->due <= now) { // skip ahead instead of bursting to catch up
+                uint64_t behind = (now - c->due) / c->period_us + 1;
+                c->missed += behind;
+                c->due += behind * c->period_us;
+            }
+        }
+        next = MIN(next, c->due);
+    }
+    k_spin_unlock(&can->cyclic_lock, key);
+
+    if (queued) {
+        k_work_schedule(&can->tx_work, K_NO_WAIT);
+    }
+    if (next != UINT64_MAX) {
+        k_timer_start(timer, K_USEC(next - now), K_NO_WAIT);
+    }
+}
+
+static void can_route_forward(can_route_t *r, const struct can_frame *frame) {
+    can_dev_data_t *dst = &can_devs[r->dst];
+    struct can_frame out = *frame;
+    out.id = (frame->id & ~r->rewrite_mask) | (r->new_id & r->rewrite_mask);
+    if (can_tx_enqueue(dst, &out, NULL)) {
+        atomic_inc(&r->dropped);
+        return;
+    }
+    atomic_inc(&r->forwarded);
+    k_work_schedule(&dst->tx_work, K_NO_WAIT);
+}
+
 static int can_init(uint16_t idx) {
     can_dev_data_t *can = &can_devs[idx];
     if (can_set_mode(can->dev, CAN_MODE_NORMAL | MODE_FLAG)) {
@@ -66,13 +671,23 @@ static int can_init(uint16_t idx) {
         LOG_ERR("failed to start can%d", idx);
         return JABI_PERIPHERAL_ERR;
     }
-    can->filter_std.id = can_add_rx_filter_msgq(can->dev, can->msgq, &can->filter_std.filter);
-    can->filter_ext.id = can_add_rx_filter_msgq(can->dev, can->msgq, &can->filter_ext.filter);
-    if (can->filter_std.id == -ENOSPC || can->filter_ext.id == -ENOSPC) {
+    if (can_filters_single(can, 0, 0) < 0) {
         LOG_ERR("failed to add filters for can%d", idx);
         return JABI_PERIPHERAL_ERR;
     }
+    k_msgq_init(&can->tx_queue, can->tx_queue_buf, sizeof(struct can_frame),
+        CONFIG_JABI_CAN_TX_QUEUE_SIZE);
+    k_work_init_delayable(&can->tx_work, can_tx_work);
     k_sem_init(&can->tx_lock, 0, 1);
+    k_timer_init(&can->cyclic_timer, can_cyclic_timer, NULL);
+    can_set_state_change_callback(can->dev, can_state_cb, can);
+#ifdef CONFIG_ISOTP
+    k_sem_init(&can->isotp.tx_done, 0, 1);
+#endif // CONFIG_ISOTP
+    if (idx == 0) {
+        can_stats_time = k_uptime_get();
+        k_work_schedule(&can_stats_dwork, K_MSEC(STATS_WINDOW_MS));
+    }
     return JABI_NO_ERR;
 }
 
@@ -80,6 +695,11 @@ static void *can_get_dev(uint16_t idx) {
     return (void*) can_devs[idx].dev;
 }
 
+static void can_rx_resize(uint16_t idx, uint8_t *buf, uint32_t size) {
+    ring_buf_init(&can_devs[idx].rx, size, buf);
+    atomic_set(&can_devs[idx].rx_count, 0);
+}
+
 PERIPH_FUNC_DEF(can_set_filter) {
     PERIPH_FUNC_GET_ARGS(can, set_filter);
     PERIPH_FUNC_CHECK_ARGS_LEN(can, set_filter);
@@ -91,22 +711,15 @@ PERIPH_FUNC_DEF(can_set_filter) {
     LOG_DBG("(id=0x%x,id_mask=0x%x)", tmp->id, tmp->id_mask);
 
     can_dev_data_t *can = &can_devs[idx];
-    can_remove_rx_filter(can->dev, can->filter_std.id);
-    can_remove_rx_filter(can->dev, can->filter_ext.id);
+    struct can_filter std = { .id = args->id, .mask = args->id_mask, .flags = 0 };
+    struct can_filter ext = { .id = args->id, .mask = args->id_mask, .flags = CAN_FILTER_IDE };
+    if ((args->id_mask <= CAN_STD_ID_MASK && can_isotp_shadowed(can, &std)) ||
+            can_isotp_shadowed(can, &ext)) {
+        LOG_ERR("filter covers the isotp rx id");
+        return JABI_INVALID_ARGS_ERR;
+    }
 
-    // RTR frames rejected by default, set CONFIG_CAN_ACCEPT_RTR=y to allow
-    can->filter_std.filter.id    = args->id;
-    can->filter_ext.filter.id    = args->id;
-    can->filter_std.filter.mask  = args->id_mask;
-    can->filter_ext.filter.mask  = args->id_mask;
-    can->filter_std.filter.flags = 0;
-    can->filter_ext.filter.flags = CAN_FILTER_IDE;
-
-    if (args->id_mask <= CAN_STD_ID_MASK) {
-        can->filter_std.id = can_add_rx_filter_msgq(can->dev, can->msgq, &can->filter_std.filter);
-    }
-    can->filter_ext.id = can_add_rx_filter_msgq(can->dev, can->msgq, &can->filter_ext.filter);
-    if (can->filter_std.id == -ENOSPC || can->filter_ext.id == -ENOSPC) {
+    if (can_filters_single(can, args->id, args->id_mask) < 0) {
         LOG_ERR("failed to change filters for can%d, old filter also removed", idx);
         return JABI_PERIPHERAL_ERR;
     }
@@ -115,6 +728,57 @@ PERIPH_FUNC_DEF(can_set_filter) {
     return JABI_NO_ERR;
 }
 
+PERIPH_FUNC_DEF(can_set_filters) {
+    PERIPH_FUNC_GET_ARGS(can, set_filters);
+    PERIPH_FUNC_GET_RET(can, set_filters);
+
+    if (req_len < sizeof(can_set_filters_req_t) ||
+        req_len != sizeof(can_set_filters_req_t) + args->num_filters * sizeof(can_filter_entry_t)) {
+        LOG_ERR("invalid amount of data provided");
+        return JABI_INVALID_ARGS_FORMAT_ERR;
+    }
+
+    LOG_DBG("(num_filters=%d)", args->num_filters);
+
+    if (args->num_filters > CONFIG_JABI_CAN_FILTERS) {
+        LOG_ERR("too many filters, max %d", CONFIG_JABI_CAN_FILTERS);
+        return JABI_INVALID_ARGS_ERR;
+    }
+
+    can_dev_data_t *can = &can_devs[idx];
+    for (int i = 0; i < args->num_filters; i++) {
+        can_filter_entry_t *e = &args->filters[i];
+        e->id = sys_le32_to_cpu(e->id);
+        e->id_mask = sys_le32_to_cpu(e->id_mask);
+        struct can_filter f = {
+            .id = e->id, .mask = e->id_mask, .flags = e->id_type ? CAN_FILTER_IDE : 0,
+        };
+        if (can_isotp_shadowed(can, &f)) {
+            LOG_ERR("filter %d covers the isotp rx id", i);
+            return JABI_INVALID_ARGS_ERR;
+        }
+    }
+    can_hw_remove(can);
+    for (int i = 0; i < args->num_filters; i++) {
+        can_filter_entry_t *e = &args->filters[i];
+        can->filters[i] = (struct can_filter) {
+            .id    = e->id,
+            .mask  = e->id_mask,
+            .flags = e->id_type ? CAN_FILTER_IDE : 0,
+        };
+    }
+    can->num_filters = args->num_filters;
+    int num_hw = can_filters_install(can);
+    if (num_hw < 0) {
+        LOG_ERR("failed to add filters for can%d (%d), old filters also removed", idx, num_hw);
+        return JABI_PERIPHERAL_ERR;
+    }
+
+    ret->num_hw = num_hw;
+    *resp_len = sizeof(can_set_filters_resp_t);
+    return JABI_NO_ERR;
+}
+
 PERIPH_FUNC_DEF(can_set_rate) {
     PERIPH_FUNC_GET_ARGS(can, set_rate);
     PERIPH_FUNC_CHECK_ARGS_LEN(can, set_rate);
@@ -133,11 +797,14 @@ PERIPH_FUNC_DEF(can_set_rate) {
         LOG_ERR("failed to set bitrate for can %d", idx);
         return JABI_PERIPHERAL_ERR;
     }
+    can->ns_per_bit = args->bitrate ? NSEC_PER_SEC / args->bitrate : 0;
+    can->ns_per_bit_data = can->ns_per_bit;
 #ifdef CONFIG_CAN_FD_MODE
     if (can_set_bitrate_data(can->dev, args->bitrate_data)) {
         LOG_ERR("failed to set data bitrate for can %d", idx);
         return JABI_PERIPHERAL_ERR;
     }
+    can->ns_per_bit_data = args->bitrate_data ? NSEC_PER_SEC / args->bitrate_data : 0;
 #endif // CONFIG_CAN_FD_MODE
     if (can_start(can->dev) == -EIO) {
         LOG_ERR("failed to restart can %d", idx);
@@ -202,17 +869,37 @@ PERIPH_FUNC_DEF(can_state) {
     return JABI_NO_ERR;
 }
 
-static void can_write_cb(const struct device *dev, int error, void* user_data) {
-    if (error) { // shouldn't happen w/ auto recovery
-        LOG_ERR("message send error %d?!", error);
+static int16_t can_frame_from_req(const can_write_req_t *args, struct can_frame *msg) {
+    if (args->data_len > CAN_MAX_DLEN) {
+        LOG_ERR("data_len too large");
+        return JABI_NOT_SUPPORTED_ERR;
     }
-    can_dev_data_t *can = (can_dev_data_t*) user_data;
-    k_sem_give(&can->tx_lock);
+    uint32_t id = sys_le32_to_cpu(args->id);
+    if (args->id_type && id > CAN_EXT_ID_MASK) {
+        LOG_WRN("id 0x%x too large for extended id", id);
+    } else if (args->id_type == 0 && id > CAN_STD_ID_MASK) {
+        LOG_WRN("id 0x%x too large for standard id", id);
+    }
+
+    *msg = (struct can_frame) {
+        .id    = id,
+        .dlc   = can_bytes_to_dlc(args->data_len),
+        .flags = (args->id_type ? CAN_FRAME_IDE : 0) |
+                 (args->rtr     ? CAN_FRAME_RTR : 0) |
+                 (args->fd      ? CAN_FRAME_FDF : 0) |
+                 (args->brs     ? CAN_FRAME_BRS : 0),
+    };
+    if (args->data_len != can_dlc_to_bytes(msg->dlc)) {
+        LOG_WRN("data_len too small for packet, padding with zeros");
+    }
+    if (!args->rtr) {
+        memcpy(msg->data, args->data, args->data_len); // rest already zeroed
+    }
+    return JABI_NO_ERR;
 }
 
 PERIPH_FUNC_DEF(can_write) {
     PERIPH_FUNC_GET_ARGS(can, write);
-    args->id = sys_le32_to_cpu(args->id);
 
     if (req_len != (sizeof(can_write_req_t) + (args->rtr ? 0 : args->data_len))) {
         LOG_ERR("invalid amount of data provided");
@@ -221,86 +908,693 @@ PERIPH_FUNC_DEF(can_write) {
 
     can_write_req_t *tmp = args;
     LOG_DBG("(id=0x%x,id_type=%d,fd=%d,brs=%d,rtr=%d,data_len=%d)",
-        tmp->id, tmp->id_type, tmp->fd, tmp->brs, tmp->rtr, tmp->data_len);
+        sys_le32_to_cpu(tmp->id), tmp->id_type, tmp->fd, tmp->brs, tmp->rtr, tmp->data_len);
     if (!args->rtr) {
         LOG_HEXDUMP_DBG(tmp->data, tmp->data_len, "data=");
     }
 
-    if (args->data_len > CAN_MAX_DLEN) {
-        LOG_ERR("data_len too large");
-        return JABI_NOT_SUPPORTED_ERR;
+    struct can_frame msg;
+    int16_t err = can_frame_from_req(args, &msg);
+    if (err) {
+        return err;
+    }
+
+    // goes through the queue behind any batch, then waits for completion
+    can_dev_data_t *can = &can_devs[idx];
+    uint32_t target; // completions are in order too
+    k_sem_reset(&can->tx_lock);
+    if (can_tx_enqueue(can, &msg, &target)) {
+        return JABI_BUSY_ERR;
     }
-    if (args->id_type && args->id > CAN_EXT_ID_MASK) {
-        LOG_WRN("id 0x%x too large for extended id", args->id);
-    } else if (args->id_type == 0 && args->id > CAN_STD_ID_MASK) {
-        LOG_WRN("id 0x%x too large for standard id", args->id);
+    k_work_schedule(&can->tx_work, K_NO_WAIT);
+    while ((int32_t) (target - atomic_get(&can->tx_sent) - atomic_get(&can->tx_failed)) > 0) {
+        if (k_sem_take(&can->tx_lock, SEND_TIMEOUT)) {
+            LOG_ERR("message didn't send in time (still in queue tho)");
+            return JABI_BUSY_ERR;
+        }
+    }
+    if (can->tx_watch_err) { // cyclic or routed frames behind us don't touch it
+        return JABI_PERIPHERAL_ERR;
     }
+    *resp_len = 0;
+    return JABI_NO_ERR;
+}
 
-    struct can_frame msg = {
-        .id    = args->id,
-        .dlc   = can_bytes_to_dlc(args->data_len),
-        .flags = (args->id_type ? CAN_FRAME_IDE : 0) |
-                 (args->rtr     ? CAN_FRAME_RTR : 0) |
-                 (args->fd      ? CAN_FRAME_FDF : 0) |
-                 (args->brs     ? CAN_FRAME_BRS : 0),
-    };
-    if (args->data_len != can_dlc_to_bytes(msg.dlc)) {
-        LOG_WRN("data_len too small for packet, padding with zeros");
-        for (int i = args->data_len; i < can_dlc_to_bytes(msg.dlc); i++) {
-            args->data[i] = 0;
+PERIPH_FUNC_DEF(can_write_many) {
+    PERIPH_FUNC_GET_ARGS(can, write_many);
+    PERIPH_FUNC_GET_RET(can, write_many);
+
+    // check the whole batch first so a bad one doesn't go out halfway
+    uint16_t num = 0;
+    for (uint16_t offset = 0; offset < req_len; num++) {
+        const can_write_req_t *m = (const can_write_req_t*) &args[offset];
+        if (req_len - offset < sizeof(can_write_req_t) ||
+            req_len - offset < sizeof(can_write_req_t) + (m->rtr ? 0 : m->data_len)) {
+            LOG_ERR("invalid amount of data provided");
+            return JABI_INVALID_ARGS_FORMAT_ERR;
+        }
+        if (m->data_len > CAN_MAX_DLEN) {
+            LOG_ERR("data_len too large");
+            return JABI_NOT_SUPPORTED_ERR;
         }
+        offset += sizeof(can_write_req_t) + (m->rtr ? 0 : m->data_len);
     }
-    memcpy(msg.data, args->data, can_dlc_to_bytes(msg.dlc));
+
+    LOG_DBG("(num=%d)", num);
 
     can_dev_data_t *can = &can_devs[idx];
-    if (can->tx_was_busy) {
-        if (k_sem_take(&can->tx_lock, K_NO_WAIT)) {
-            return JABI_BUSY_ERR;
+    uint16_t queued = 0;
+    for (uint16_t offset = 0; queued < num; queued++) {
+        const can_write_req_t *m = (const can_write_req_t*) &args[offset];
+        struct can_frame msg;
+        can_frame_from_req(m, &msg);
+        if (can_tx_enqueue(can, &msg, NULL)) {
+            break; // host resends the rest
         }
+        offset += sizeof(can_write_req_t) + (m->rtr ? 0 : m->data_len);
     }
-    if (can_send(can->dev, &msg, K_NO_WAIT, can_write_cb, can)) {
-        LOG_ERR("couldn't send message");
-        return JABI_PERIPHERAL_ERR;
+    k_work_schedule(&can->tx_work, K_NO_WAIT);
+
+    ret->num_queued = sys_cpu_to_le16(queued);
+    ret->num_free = sys_cpu_to_le16(k_msgq_num_free_get(&can->tx_queue));
+    *resp_len = sizeof(can_write_many_resp_t);
+    return JABI_NO_ERR;
+}
+
+PERIPH_FUNC_DEF(can_tx_stats) {
+    PERIPH_FUNC_GET_RET(can, tx_stats);
+    PERIPH_FUNC_CHECK_ARGS_EMPTY;
+
+    LOG_DBG("()");
+
+    can_dev_data_t *can = &can_devs[idx];
+    ret->queued = sys_cpu_to_le32(atomic_get(&can->tx_queued));
+    ret->sent = sys_cpu_to_le32(atomic_get(&can->tx_sent));
+    ret->failed = sys_cpu_to_le32(atomic_get(&can->tx_failed));
+    ret->pending = sys_cpu_to_le16(k_msgq_num_used_get(&can->tx_queue) + atomic_get(&can->tx_busy));
+    *resp_len = sizeof(can_tx_stats_resp_t);
+    return JABI_NO_ERR;
+}
+
+PERIPH_FUNC_DEF(can_cyclic_set) {
+    PERIPH_FUNC_GET_ARGS(can, cyclic_set);
+
+    const can_write_req_t *m = (const can_write_req_t*) args->msg;
+    if (req_len < sizeof(can_cyclic_set_req_t) + sizeof(can_write_req_t) ||
+        req_len != sizeof(can_cyclic_set_req_t) + sizeof(can_write_req_t) + (m->rtr ? 0 : m->data_len)) {
+        LOG_ERR("invalid amount of data provided");
+        return JABI_INVALID_ARGS_FORMAT_ERR;
     }
-    // wait for completion to ensure FIFO sending
-    if (k_sem_take(&can->tx_lock, SEND_TIMEOUT)) {
-        LOG_ERR("message didn't send in time (still in queue tho)");
-        can->tx_was_busy = true;
-        return JABI_BUSY_ERR;
+    args->period_us = sys_le32_to_cpu(args->period_us);
+    args->offset_us = sys_le32_to_cpu(args->offset_us);
+
+    can_cyclic_set_req_t *tmp = args;
+    LOG_DBG("(slot=%d,period_us=%d,offset_us=%d,counter=%d/%d,checksum=%d/%d,id=0x%x)",
+        tmp->slot, tmp->period_us, tmp->offset_us, tmp->counter_byte, tmp->counter_bits,
+        tmp->checksum_byte, tmp->checksum_type, sys_le32_to_cpu(m->id));
+
+    if (args->slot >= CONFIG_JABI_CAN_CYCLIC_SLOTS || args->counter_bits > 8 ||
+            args->checksum_type > CHECKSUM_CRC8_SAE_J1850) {
+        LOG_ERR("invalid slot, counter or checksum");
+        return JABI_INVALID_ARGS_ERR;
+    }
+    struct can_frame frame;
+    int16_t err = can_frame_from_req(m, &frame);
+    if (err) {
+        return err;
+    }
+
+    can_dev_data_t *can = &can_devs[idx];
+    can_cyclic_t *c = &can->cyclic[args->slot];
+    k_spinlock_key_t key = k_spin_lock(&can->cyclic_lock);
+    if (!c->period_us) { // new, otherwise keep phase and counter
+        *c = (can_cyclic_t) {
+            .due = jabi_time_us() + args->offset_us,
+        };
     }
-    can->tx_was_busy = false;
+    c->frame = frame;
+    c->period_us = args->period_us;
+    c->counter_byte = args->counter_byte;
+    c->counter_bits = args->counter_bits;
+    c->checksum_byte = args->checksum_byte;
+    c->checksum_type = args->checksum_type;
+    k_spin_unlock(&can->cyclic_lock, key);
+
+    k_timer_start(&can->cyclic_timer, K_NO_WAIT, K_NO_WAIT); // reschedules off the new table
     *resp_len = 0;
     return JABI_NO_ERR;
 }
 
+PERIPH_FUNC_DEF(can_cyclic_stats) {
+    PERIPH_FUNC_GET_RET(can, cyclic_stats);
+    PERIPH_FUNC_CHECK_ARGS_EMPTY;
+
+    LOG_DBG("()");
+
+    can_dev_data_t *can = &can_devs[idx];
+    uint8_t num = 0;
+    k_spinlock_key_t key = k_spin_lock(&can->cyclic_lock);
+    for (int i = 0; i < CONFIG_JABI_CAN_CYCLIC_SLOTS; i++) {
+        can_cyclic_t *c = &can->cyclic[i];
+        if (!c->period_us || sizeof(can_cyclic_stats_resp_t) +
+                (num + 1) * sizeof(can_cyclic_entry_t) > RESP_PAYLOAD_MAX_SIZE) {
+            continue;
+        }
+        ret->entries[num].slot = i;
+        ret->entries[num].period_us = sys_cpu_to_le32(c->period_us);
+        ret->entries[num].sent = sys_cpu_to_le32(c->sent);
+        ret->entries[num].missed = sys_cpu_to_le32(c->missed);
+        num++;
+    }
+    k_spin_unlock(&can->cyclic_lock, key);
+
+    ret->num_entries = num;
+    *resp_len = sizeof(can_cyclic_stats_resp_t) + num * sizeof(can_cyclic_entry_t);
+    return JABI_NO_ERR;
+}
+
+PERIPH_FUNC_DEF(can_route_set) {
+    PERIPH_FUNC_GET_ARGS(can, route_set);
+    PERIPH_FUNC_CHECK_ARGS_LEN(can, route_set);
+
+    args->id           = sys_le32_to_cpu(args->id);
+    args->id_mask      = sys_le32_to_cpu(args->id_mask);
+    args->dst          = sys_le16_to_cpu(args->dst);
+    args->rewrite_mask = sys_le32_to_cpu(args->rewrite_mask);
+    args->new_id       = sys_le32_to_cpu(args->new_id);
+
+    can_route_set_req_t *tmp = args;
+    LOG_DBG("(route=%d,enable=%d,id=0x%x,id_mask=0x%x,id_type=%d,dst=%d,rewrite_mask=0x%x,new_id=0x%x)",
+        tmp->route, tmp->enable, tmp->id, tmp->id_mask, tmp->id_type, tmp->dst,
+        tmp->rewrite_mask, tmp->new_id);
+
+    if (args->route >= CONFIG_JABI_CAN_ROUTES) {
+        LOG_ERR("invalid route");
+        return JABI_INVALID_ARGS_ERR;
+    }
+    if (args->enable && (args->dst >= ARRAY_SIZE(can_devs) || args->dst == idx)) {
+        LOG_ERR("invalid destination can%d", args->dst); // own tx isn't received back
+        return JABI_INVALID_ARGS_ERR;
+    }
+    if (args->enable && (args->new_id & args->rewrite_mask) &
+            ~(args->id_type ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK)) {
+        LOG_ERR("rewritten id doesn't fit the id type");
+        return JABI_INVALID_ARGS_ERR;
+    }
+
+    struct can_filter filter = {
+        .id    = args->id,
+        .mask  = args->id_mask,
+        .flags = args->id_type ? CAN_FILTER_IDE : 0,
+    };
+    can_dev_data_t *can = &can_devs[idx];
+    if (args->enable && can_isotp_shadowed(can, &filter)) {
+        LOG_ERR("route covers the isotp rx id");
+        return JABI_INVALID_ARGS_ERR;
+    }
+
+    can_route_t *r = &can->routes[args->route];
+    can_hw_remove(can); // no more callbacks until reinstalled
+    can_route_t prev = *r;
+    r->active = false;
+    if (args->enable) {
+        r->filter = filter;
+        r->dst = args->dst;
+        r->rewrite_mask = args->rewrite_mask;
+        r->new_id = args->new_id;
+        if (!prev.active) {
+            atomic_clear(&r->forwarded);
+            atomic_clear(&r->dropped);
+        }
+        r->active = true;
+    }
+    int err = can_filters_install(can);
+    if (err < 0) {
+        LOG_ERR("failed to add filters for can%d (%d), keeping the old route", idx, err);
+        r->active = prev.active;
+        r->filter = prev.filter;
+        r->dst = prev.dst;
+        r->rewrite_mask = prev.rewrite_mask;
+        r->new_id = prev.new_id;
+        can_filters_install(can);
+        return JABI_PERIPHERAL_ERR;
+    }
+
+    *resp_len = 0;
+    return JABI_NO_ERR;
+}
+
+PERIPH_FUNC_DEF(can_route_stats) {
+    PERIPH_FUNC_GET_RET(can, route_stats);
+    PERIPH_FUNC_CHECK_ARGS_EMPTY;
+
+    LOG_DBG("()");
+
+    can_dev_data_t *can = &can_devs[idx];
+    uint8_t num = 0;
+    for (int i = 0; i < CONFIG_JABI_CAN_ROUTES; i++) {
+        can_route_t *r = &can->routes[i];
+        if (!r->active || sizeof(can_route_stats_resp_t) +
+                (num + 1) * sizeof(can_route_entry_t) > RESP_PAYLOAD_MAX_SIZE) {
+            continue;
+        }
+        ret->entries[num].route = i;
+        ret->entries[num].dst = sys_cpu_to_le16(r->dst);
+        ret->entries[num].forwarded = sys_cpu_to_le32(atomic_get(&r->forwarded));
+        ret->entries[num].dropped = sys_cpu_to_le32(atomic_get(&r->dropped));
+        num++;
+    }
+
+    ret->num_entries = num;
+    *resp_len = sizeof(can_route_stats_resp_t) + num * sizeof(can_route_entry_t);
+    return JABI_NO_ERR;
+}
+
+static void can_rx_check_dropped(can_dev_data_t *can, uint16_t idx) {
+    long dropped = atomic_clear(&can->rx_dropped);
+    if (dropped) {
+        LOG_WRN("can%d buffer full, dropped %ld frames", idx, dropped);
+    }
+}
+
 PERIPH_FUNC_DEF(can_read) {
     PERIPH_FUNC_GET_RET(can, read);
     PERIPH_FUNC_CHECK_ARGS_EMPTY;
 
     LOG_DBG("()");
 
-    struct can_frame msg;
+    can_rx_hdr_t hdr;
     can_dev_data_t *can = &can_devs[idx];
-    if (k_msgq_get(can->msgq, &msg, K_NO_WAIT)) {
+    can_rx_check_dropped(can, idx);
+    if (atomic_get(&can->rx_count) == 0) {
         *resp_len = 0;
         return JABI_NO_ERR;
     }
+    ring_buf_get(&can->rx, (uint8_t*) &hdr, sizeof(hdr));
+    if (hdr.flags & RX_HDR_TS) {
+        ring_buf_get(&can->rx, NULL, sizeof(can_rx_ts_t));
+    }
 
-    ret->num_left = sys_cpu_to_le16(k_msgq_num_used_get(can->msgq));
-    ret->id       = sys_cpu_to_le32(msg.id);
-    ret->id_type  = msg.flags & CAN_FRAME_IDE;
-    ret->fd       = msg.flags & CAN_FRAME_FDF; // not always accurate
-    ret->brs      = msg.flags & CAN_FRAME_BRS; // not always accurate
-    ret->rtr      = msg.flags & CAN_FRAME_RTR;
-    ret->data_len = can_dlc_to_bytes(msg.dlc);
+    ret->num_left = sys_cpu_to_le16(atomic_dec(&can->rx_count) - 1);
+    ret->id       = sys_cpu_to_le32(hdr.id);
+    ret->id_type  = (hdr.flags & CAN_FRAME_IDE) != 0;
+    ret->fd       = (hdr.flags & CAN_FRAME_FDF) != 0; // not always accurate
+    ret->brs      = (hdr.flags & CAN_FRAME_BRS) != 0; // not always accurate
+    ret->rtr      = (hdr.flags & CAN_FRAME_RTR) != 0;
+    ret->data_len = can_dlc_to_bytes(hdr.dlc);
     *resp_len = sizeof(can_read_resp_t);
     if (!ret->rtr) {
-        memcpy(ret->data, msg.data, ret->data_len);
+        ring_buf_get(&can->rx, ret->data, ret->data_len);
         *resp_len += ret->data_len;
     }
     return JABI_NO_ERR;
 }
 
+static int16_t can_read_many_common(uint16_t idx, can_read_many_req_t *args, uint16_t req_len,
+                                    can_read_many_resp_t *ret, uint16_t *resp_len, bool ts) {
+    if (req_len != sizeof(can_read_many_req_t)) {
+        return JABI_INVALID_ARGS_FORMAT_ERR;
+    }
+    args->max_msgs = sys_le16_to_cpu(args->max_msgs);
+
+    LOG_DBG("(max_msgs=%d,ts=%d)", args->max_msgs, ts);
+
+    can_dev_data_t *can = &can_devs[idx];
+    can_rx_check_dropped(can, idx);
+    if (ts) {
+        atomic_set(&can->rx_ts, 1);
+    }
+
+    // take whole frames until the next one doesn't fit
+    uint16_t ts_len = ts ? sizeof(can_read_many_ts_msg_t) - sizeof(can_read_many_msg_t) : 0;
+    uint16_t num = 0, len = sizeof(can_read_many_resp_t);
+    while ((args->max_msgs == 0 || num < args->max_msgs) && atomic_get(&can->rx_count) > 0) {
+        can_rx_hdr_t hdr;
+        ring_buf_peek(&can->rx, (uint8_t*) &hdr, sizeof(hdr));
+        bool rtr = (hdr.flags & CAN_FRAME_RTR) != 0;
+        uint8_t data_len = can_dlc_to_bytes(hdr.dlc);
+        uint16_t msg_len = ts_len + sizeof(can_read_many_msg_t) + (rtr ? 0 : data_len);
+        if (len + msg_len > RESP_PAYLOAD_MAX_SIZE) {
+            break;
+        }
+        ring_buf_get(&can->rx, NULL, sizeof(hdr));
+        can_rx_ts_t rx_ts = { 0 }; // frames from before the first timestamped read have none
+        if (hdr.flags & RX_HDR_TS) {
+            ring_buf_get(&can->rx, (uint8_t*) &rx_ts, sizeof(rx_ts));
+        }
+
+        uint8_t *out = &ret->msgs[len - sizeof(can_read_many_resp_t)];
+        if (ts) {
+            can_read_many_ts_msg_t *t = (can_read_many_ts_msg_t*) out;
+            t->timestamp = sys_cpu_to_le64(rx_ts.timestamp);
+            t->hw_timestamp = sys_cpu_to_le16(rx_ts.hw_timestamp);
+        }
+        can_read_many_msg_t *msg = (can_read_many_msg_t*) &out[ts_len]; // rest is the same
+        msg->id       = sys_cpu_to_le32(hdr.id);
+        msg->id_type  = (hdr.flags & CAN_FRAME_IDE) != 0;
+        msg->fd       = (hdr.flags & CAN_FRAME_FDF) != 0; // not always accurate
+        msg->brs      = (hdr.flags & CAN_FRAME_BRS) != 0; // not always accurate
+        msg->rtr      = rtr;
+        msg->data_len = data_len;
+        if (!rtr) {
+            ring_buf_get(&can->rx, msg->data, data_len);
+        }
+        atomic_dec(&can->rx_count);
+        len += msg_len;
+        num++;
+    }
+
+    ret->num_left = sys_cpu_to_le16(atomic_get(&can->rx_count));
+    ret->num_msgs = sys_cpu_to_le16(num);
+    *resp_len = len;
+    return JABI_NO_ERR;
+}
+
+PERIPH_FUNC_DEF(can_read_many) {
+    PERIPH_FUNC_GET_ARGS(can, read_many);
+    PERIPH_FUNC_GET_RET(can, read_many);
+    return can_read_many_common(idx, args, req_len, ret, resp_len, false);
+}
+
+PERIPH_FUNC_DEF(can_read_many_ts) {
+    PERIPH_FUNC_GET_ARGS(can, read_many);
+    PERIPH_FUNC_GET_RET(can, read_many);
+    return can_read_many_common(idx, args, req_len, ret, resp_len, true);
+}
+
+PERIPH_FUNC_DEF(can_bus_stats) {
+    PERIPH_FUNC_GET_ARGS(can, bus_stats);
+    PERIPH_FUNC_GET_RET(can, bus_stats);
+    PERIPH_FUNC_CHECK_ARGS_LEN(can, bus_stats);
+
+    LOG_DBG("(reset_ids=%d)", args->reset_ids);
+
+    can_dev_data_t *can = &can_devs[idx];
+    ret->rx_frames = sys_cpu_to_le32(atomic_get(&can->bus[BUS_RX_FRAMES]));
+    ret->rx_bytes = sys_cpu_to_le32(atomic_get(&can->bus[BUS_RX_BYTES]));
+    ret->tx_frames = sys_cpu_to_le32(atomic_get(&can->bus[BUS_TX_FRAMES]));
+    ret->tx_bytes = sys_cpu_to_le32(atomic_get(&can->bus[BUS_TX_BYTES]));
+    ret->rx_frame_rate = sys_cpu_to_le32(can->bus_rate[BUS_RX_FRAMES]);
+    ret->rx_byte_rate = sys_cpu_to_le32(can->bus_rate[BUS_RX_BYTES]);
+    ret->tx_frame_rate = sys_cpu_to_le32(can->bus_rate[BUS_TX_FRAMES]);
+    ret->tx_byte_rate = sys_cpu_to_le32(can->bus_rate[BUS_TX_BYTES]);
+    ret->bus_load = sys_cpu_to_le16(MIN(can->bus_rate[BUS_TIME_NS] / (NSEC_PER_SEC / 10000), 10000));
+#ifdef CONFIG_CAN_STATS
+    ret->bit0_errors = sys_cpu_to_le32(can_stats_get_bit0_errors(can->dev));
+    ret->bit1_errors = sys_cpu_to_le32(can_stats_get_bit1_errors(can->dev));
+    ret->stuff_errors = sys_cpu_to_le32(can_stats_get_stuff_errors(can->dev));
+    ret->crc_errors = sys_cpu_to_le32(can_stats_get_crc_errors(can->dev));
+    ret->form_errors = sys_cpu_to_le32(can_stats_get_form_errors(can->dev));
+    ret->ack_errors = sys_cpu_to_le32(can_stats_get_ack_errors(can->dev));
+    ret->rx_overruns = sys_cpu_to_le32(can_stats_get_rx_overruns(can->dev));
+#else
+    ret->bit0_errors = ret->bit1_errors = ret->stuff_errors = ret->crc_errors = 0;
+    ret->form_errors = ret->ack_errors = ret->rx_overruns = 0;
+#endif // CONFIG_CAN_STATS
+    ret->error_warning = sys_cpu_to_le32(atomic_get(&can->error_warning));
+    ret->error_passive = sys_cpu_to_le32(atomic_get(&can->error_passive));
+    ret->bus_off = sys_cpu_to_le32(atomic_get(&can->bus_off));
+    bool accept_all[2] = { false, false };
+    for (int i = 0; i < can->num_hw; i++) {
+        if (can->hw[i].filter.mask == 0) {
+            accept_all[(can->hw[i].filter.flags & CAN_FILTER_IDE) != 0] = true;
+        }
+    }
+    ret->filtered = !accept_all[0] || !accept_all[1];
+
+    can_top_id_t top[CONFIG_JABI_CAN_TOP_IDS];
+    k_spinlock_key_t lock = k_spin_lock(&can->top_lock);
+    memcpy(top, can->top, sizeof(top));
+    if (args->reset_ids) {
+        memset(can->top, 0, sizeof(can->top));
+    }
+    k_spin_unlock(&can->top_lock, lock);
+
+    // most frequent first, only as many as fit
+    int max_ids = (RESP_PAYLOAD_MAX_SIZE - sizeof(can_bus_stats_resp_t)) / sizeof(can_bus_stats_id_t);
+    int num = 0;
+    for (int i = 0; i < CONFIG_JABI_CAN_TOP_IDS && num < max_ids; i++) {
+        can_top_id_t *best = NULL;
+        for (int j = 0; j < CONFIG_JABI_CAN_TOP_IDS; j++) {
+            if (top[j].count && (!best || top[j].count > best->count)) {
+                best = &top[j];
+            }
+        }
+        if (!best) {
+            break;
+        }
+        ret->ids[num].id = sys_cpu_to_le32(best->key & ~BIT(31));
+        ret->ids[num].id_type = (best->key & BIT(31)) != 0;
+        ret->ids[num].count = sys_cpu_to_le32(best->count);
+        best->count = 0;
+        num++;
+    }
+    ret->num_ids = num;
+    *resp_len = sizeof(can_bus_stats_resp_t) + num * sizeof(can_bus_stats_id_t);
+    return JABI_NO_ERR;
+}
+
+#ifdef CONFIG_ISOTP
+static void can_isotp_rx_reset(can_isotp_data_t *tp) {
+    if (tp->rx_buf) {
+        net_buf_unref(tp->rx_buf);
+        tp->rx_buf = NULL;
+    }
+    tp->rx_total = 0;
+    tp->rx_offset = 0;
+    tp->rx_rem = 0;
+}
+
+static void can_isotp_tx_cb(int error_nr, void *arg) {
+    can_isotp_data_t *tp = arg;
+    tp->tx_err = error_nr;
+    atomic_clear(&tp->tx_busy);
+    k_sem_give(&tp->tx_done);
+}
+
+static void can_isotp_addr(struct isotp_msg_id *addr, uint32_t id, uint8_t ext_addr,
+                           const can_isotp_bind_req_t *args) {
+    *addr = (struct isotp_msg_id) {
+        .ext_addr = ext_addr,
+        .dl       = args->tx_dl,
+        .flags    = (args->id_type  ? ISOTP_MSG_IDE      : 0) |
+                    (args->fd       ? ISOTP_MSG_FDF      : 0) |
+                    (args->brs      ? ISOTP_MSG_BRS      : 0) |
+                    (args->ext_addr ? ISOTP_MSG_EXT_ADDR : 0),
+    };
+    if (args->id_type) {
+        addr->ext_id = id;
+    } else {
+        addr->std_id = id;
+    }
+}
+#endif // CONFIG_ISOTP
+
+PERIPH_FUNC_DEF(can_isotp_bind) {
+    PERIPH_FUNC_GET_ARGS(can, isotp_bind);
+    PERIPH_FUNC_CHECK_ARGS_LEN(can, isotp_bind);
+
+    args->tx_id = sys_le32_to_cpu(args->tx_id);
+    args->rx_id = sys_le32_to_cpu(args->rx_id);
+
+    can_isotp_bind_req_t *tmp = args;
+    LOG_DBG("(tx_id=0x%x,rx_id=0x%x,id_type=%d,fd=%d,brs=%d,tx_dl=%d,ext_addr=%d,bs=%d,stmin=%d)",
+        tmp->tx_id, tmp->rx_id, tmp->id_type, tmp->fd, tmp->brs, tmp->tx_dl, tmp->ext_addr,
+        tmp->bs, tmp->stmin);
+
+#ifdef CONFIG_ISOTP
+    can_dev_data_t *can = &can_devs[idx];
+    can_isotp_data_t *tp = &can->isotp;
+    if (atomic_get(&tp->tx_busy)) {
+        LOG_ERR("can%d isotp still sending", idx);
+        return JABI_BUSY_ERR;
+    }
+    struct can_filter rx_filter = {
+        .id    = args->rx_id,
+        .mask  = args->id_type ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK,
+        .flags = args->id_type ? CAN_FILTER_IDE : 0,
+    };
+    for (int i = 0; i < can->num_hw; i++) {
+        if (can_filters_overlap(&can->hw[i].filter, &rx_filter)) {
+            LOG_ERR("can%d filters or routes cover rx id 0x%x, narrow them first", idx, args->rx_id);
+            return JABI_INVALID_ARGS_ERR;
+        }
+    }
+    if (tp->bound) {
+        isotp_unbind(&tp->recv_ctx);
+        tp->bound = false;
+    }
+    can_isotp_rx_reset(tp);
+
+    can_isotp_addr(&tp->tx_addr, args->tx_id, args->tx_ext_addr, args);
+    can_isotp_addr(&tp->rx_addr, args->rx_id, args->rx_ext_addr, args);
+    struct isotp_fc_opts opts = {
+        .bs = args->bs,
+        .stmin = args->stmin,
+    };
+    int err = isotp_bind(&tp->recv_ctx, can->dev, &tp->rx_addr, &tp->tx_addr, &opts, K_NO_WAIT);
+    if (err != ISOTP_N_OK) {
+        LOG_ERR("failed to bind isotp for can%d (%d)", idx, err);
+        return JABI_PERIPHERAL_ERR;
+    }
+    tp->rx_filter = rx_filter;
+    tp->bound = true;
+
+    *resp_len = 0;
+    return JABI_NO_ERR;
+#else
+    LOG_ERR("isotp disabled");
+    return JABI_NOT_SUPPORTED_ERR;
+#endif // CONFIG_ISOTP
+}
+
+PERIPH_FUNC_DEF(can_isotp_send) {
+    PERIPH_FUNC_GET_ARGS(can, isotp_send);
+
+    if (req_len < sizeof(can_isotp_send_req_t)) {
+        LOG_ERR("invalid amount of data provided");
+        return JABI_INVALID_ARGS_FORMAT_ERR;
+    }
+    args->total_len = sys_le16_to_cpu(args->total_len);
+    args->offset = sys_le16_to_cpu(args->offset);
+    uint16_t len = req_len - sizeof(can_isotp_send_req_t);
+
+    can_isotp_send_req_t *tmp = args;
+    LOG_DBG("(total_len=%d,offset=%d,len=%d)", tmp->total_len, tmp->offset, len);
+
+#ifdef CONFIG_ISOTP
+    PERIPH_FUNC_GET_RET(can, isotp_send);
+    can_dev_data_t *can = &can_devs[idx];
+    can_isotp_data_t *tp = &can->isotp;
+    if (!tp->bound) {
+        LOG_ERR("can%d isotp not bound", idx);
+        return JABI_INVALID_ARGS_ERR;
+    }
+
+    if (args->total_len) {
+        if (atomic_get(&tp->tx_busy)) { // buffer still being sent from
+            LOG_ERR("can%d isotp still sending", idx);
+            return JABI_BUSY_ERR;
+        }
+        if (args->offset == 0) {
+            tp->tx_staged = 0;
+        }
+        if (args->total_len > sizeof(tp->tx_buf) || args->offset != tp->tx_staged ||
+                args->offset + len > args->total_len) {
+            LOG_ERR("invalid chunk, total_len=%d offset=%d staged=%d",
+                args->total_len, args->offset, tp->tx_staged);
+            tp->tx_staged = 0;
+            return JABI_INVALID_ARGS_ERR;
+        }
+        memcpy(&tp->tx_buf[args->offset], args->data, len);
+        tp->tx_staged += len;
+        if (tp->tx_staged < args->total_len) {
+            ret->done = 0;
+            *resp_len = sizeof(can_isotp_send_resp_t);
+            return JABI_NO_ERR;
+        }
+
+        tp->tx_staged = 0;
+        k_sem_reset(&tp->tx_done);
+        atomic_set(&tp->tx_busy, 1);
+        int err = isotp_send(&tp->send_ctx, can->dev, tp->tx_buf, args->total_len,
+            &tp->tx_addr, &tp->rx_addr, can_isotp_tx_cb, tp);
+        if (err != ISOTP_N_OK) {
+            LOG_ERR("failed to start isotp send on can%d (%d)", idx, err);
+            atomic_clear(&tp->tx_busy);
+            return JABI_PERIPHERAL_ERR;
+        }
+    }
+
+    // most PDUs finish well within this, slow STmin may need a few asks
+    if (atomic_get(&tp->tx_busy) && k_sem_take(&tp->tx_done, K_MSEC(ISOTP_WAIT_MS))) {
+        ret->done = 0;
+        *resp_len = sizeof(can_isotp_send_resp_t);
+        return JABI_NO_ERR;
+    }
+    if (tp->tx_err != ISOTP_N_OK) {
+        LOG_ERR("isotp send on can%d failed (%d)", idx, tp->tx_err);
+        return JABI_PERIPHERAL_ERR;
+    }
+    ret->done = 1;
+    *resp_len = sizeof(can_isotp_send_resp_t);
+    return JABI_NO_ERR;
+#else
+    LOG_ERR("isotp disabled");
+    return JABI_NOT_SUPPORTED_ERR;
+#endif // CONFIG_ISOTP
+}
+
+PERIPH_FUNC_DEF(can_isotp_recv) {
+    PERIPH_FUNC_GET_ARGS(can, isotp_recv);
+    PERIPH_FUNC_CHECK_ARGS_LEN(can, isotp_recv);
+
+    args->timeout_ms = sys_le16_to_cpu(args->timeout_ms);
+
+    LOG_DBG("(timeout_ms=%d)", args->timeout_ms);
+
+#ifdef CONFIG_ISOTP
+    PERIPH_FUNC_GET_RET(can, isotp_recv);
+    can_isotp_data_t *tp = &can_devs[idx].isotp;
+    if (!tp->bound) {
+        LOG_ERR("can%d isotp not bound", idx);
+        return JABI_INVALID_ARGS_ERR;
+    }
+    if (tp->rx_total && tp->rx_offset == tp->rx_total) {
+        can_isotp_rx_reset(tp); // last PDU fully returned
+    }
+
+    // only block for the first fragment, then take whatever else is ready
+    k_timeout_t wait = K_MSEC(MIN(args->timeout_ms, ISOTP_WAIT_MS));
+    uint16_t max = RESP_PAYLOAD_MAX_SIZE - sizeof(can_isotp_recv_resp_t);
+    uint16_t len = 0;
+    while (len < max) {
+        if (!tp->rx_buf) {
+            if (tp->rx_total && tp->rx_rem == 0) {
+                break; // rest of the PDU already buffered here
+            }
+            struct net_buf *buf;
+            int rem = isotp_recv_net(&tp->recv_ctx, &buf, len ? K_NO_WAIT : wait);
+            if (rem == ISOTP_RECV_TIMEOUT) {
+                break;
+            }
+            if (rem < 0) {
+                LOG_ERR("isotp receive on can%d failed (%d)", idx, rem);
+                can_isotp_rx_reset(tp);
+                return JABI_PERIPHERAL_ERR;
+            }
+            if (!tp->rx_total) {
+                size_t total = net_buf_frags_len(buf) + rem;
+                if (total > UINT16_MAX) {
+                    LOG_ERR("isotp PDU of %u bytes too large", (unsigned int) total);
+                    net_buf_unref(buf);
+                    return JABI_NOT_SUPPORTED_ERR; // subsystem drops the rest
+                }
+                tp->rx_total = total;
+            }
+            tp->rx_buf = buf;
+            tp->rx_rem = rem;
+        }
+        uint16_t n = MIN(tp->rx_buf->len, max - len);
+        memcpy(&ret->data[len], tp->rx_buf->data, n);
+        net_buf_pull(tp->rx_buf, n);
+        len += n;
+        if (tp->rx_buf->len == 0) {
+            tp->rx_buf = net_buf_frag_del(NULL, tp->rx_buf);
+        }
+    }
+
+    ret->total_len = sys_cpu_to_le16(tp->rx_total);
+    ret->offset = sys_cpu_to_le16(tp->rx_offset);
+    tp->rx_offset += len;
+    *resp_len = sizeof(can_isotp_recv_resp_t) + len;
+    return JABI_NO_ERR;
+#else
+    LOG_ERR("isotp disabled");
+    return JABI_NOT_SUPPORTED_ERR;
+#endif // CONFIG_ISOTP
+}
+
 static const periph_func_t can_periph_fns[] = {
     can_set_filter,
     can_set_rate,
@@ -308,8 +1602,24 @@ static const periph_func_t can_periph_fns[] = {
     can_state,
     can_write,
     can_read,
+    can_read_many,
+    can_write_many,
+    can_tx_stats,
+    can_read_many_ts,
+    can_bus_stats,
+    can_isotp_bind,
+    can_isotp_send,
+    can_isotp_recv,
+    can_cyclic_set,
+    can_cyclic_stats,
+    can_route_set,
+    can_route_stats,
+    can_set_filters,
 };
 
+static periph_stats_t can_stats[DT_PROP_LEN(JABI_PERIPH_NODE, can)];
+static periph_fn_stats_t can_fn_stats[ARRAY_SIZE(can_periph_fns)];
+
 const struct periph_api_t can_periph_api = {
     .init = can_init,
     .get_dev = can_get_dev,
@@ -317,6 +1627,9 @@ const struct periph_api_t can_periph_api = {
     .num_fns = ARRAY_SIZE(can_periph_fns),
     .num_idx = DT_PROP_LEN(JABI_PERIPH_NODE, can),
     .name = "can",
+    .rx_resize = can_rx_resize,
+    .stats = can_stats,
+    .fn_stats = can_fn_stats,
 };
 
 #else
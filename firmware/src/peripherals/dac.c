@@ -63,6 +63,9 @@ static const periph_func_t dac_periph_fns[] = {
     dac_write,
 };
 
+static periph_stats_t dac_stats[ARRAY_SIZE(dac_devs)];
+static periph_fn_stats_t dac_fn_stats[ARRAY_SIZE(dac_periph_fns)];
+
 const struct periph_api_t dac_periph_api = {
     .init = dac_init,
     .get_dev = dac_get_dev,
@@ -70,6 +73,8 @@ const struct periph_api_t dac_periph_api = {
     .num_fns = ARRAY_SIZE(dac_periph_fns),
     .num_idx = ARRAY_SIZE(dac_devs),
     .name = "dac",
+    .stats = dac_stats,
+    .fn_stats = dac_fn_stats,
 };
 
 #else
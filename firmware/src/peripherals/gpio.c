@@ -93,6 +93,9 @@ static const periph_func_t gpio_periph_fns[] = {
     gpio_read,
 };
 
+static periph_stats_t gpio_stats[DT_PROP_LEN(JABI_PERIPH_NODE, gpio)];
+static periph_fn_stats_t gpio_fn_stats[ARRAY_SIZE(gpio_periph_fns)];
+
 const struct periph_api_t gpio_periph_api = {
     .init = gpio_init,
     .get_dev = gpio_get_dev,
@@ -100,6 +103,8 @@ const struct periph_api_t gpio_periph_api = {
     .num_fns = ARRAY_SIZE(gpio_periph_fns),
     .num_idx = DT_PROP_LEN(JABI_PERIPH_NODE, gpio),
     .name = "gpio",
+    .stats = gpio_stats,
+    .fn_stats = gpio_fn_stats,
 };
 
 #else
@@ -128,6 +128,9 @@ static const periph_func_t i2c_periph_fns[] = {
     i2c_transceive,
 };
 
+static periph_stats_t i2c_stats[DT_PROP_LEN(JABI_PERIPH_NODE, i2c)];
+static periph_fn_stats_t i2c_fn_stats[ARRAY_SIZE(i2c_periph_fns)];
+
 const struct periph_api_t i2c_periph_api = {
     .init = i2c_init,
     .get_dev = i2c_get_dev,
@@ -135,6 +138,8 @@ const struct periph_api_t i2c_periph_api = {
     .num_fns = ARRAY_SIZE(i2c_periph_fns),
     .num_idx = DT_PROP_LEN(JABI_PERIPH_NODE, i2c),
     .name = "i2c",
+    .stats = i2c_stats,
+    .fn_stats = i2c_fn_stats,
 };
 
 #else
@@ -26,7 +26,7 @@ typedef struct {
 } lin_dev_data_t;
 
 #define GEN_LIN_MSGQS(node_id, prop, idx) \
-    K_MSGQ_DEFINE(lin_rx_msgq##idx, sizeof(struct lin_frame), CONFIG_JABI_LIN_BUFFER_SIZE, 4);
+    static struct k_msgq lin_rx_msgq##idx; // buffer is a slice of the rx arena
 
 #define GEN_LIN_DEV_DATA(node_id, prop, idx)                      \
     {                                                             \
@@ -76,9 +76,12 @@ static void lin_rx_cb(const struct device *dev, int error, const struct lin_fram
     lin_dev_data_t *lin = (lin_dev_data_t*) arg;
     lin->status.retcode = error;
     if (!error) {
-        if (k_msgq_put(lin->rx_msgs, msg, K_NO_WAIT)) {
+        bool dropped = k_msgq_put(lin->rx_msgs, msg, K_NO_WAIT) != 0;
+        if (dropped) {
             LOG_ERR("overflow, unable to store message %d", msg->id);
         }
+        periph_stats_rx(periph_stats(PERIPH_LIN_ID, lin - lin_devs), 1, dropped,
+                        k_msgq_num_used_get(lin->rx_msgs) * sizeof(struct lin_frame));
     }
     if (lin->mode == 0) {
         k_sem_give(&lin->cmd_lock);
@@ -113,6 +116,10 @@ static void *lin_get_dev(uint16_t idx) {
     return (void*) lin_devs[idx].dev;
 }
 
+static void lin_rx_resize(uint16_t idx, uint8_t *buf, uint32_t size) {
+    k_msgq_init(lin_devs[idx].rx_msgs, (char*) buf, sizeof(struct lin_frame), size / sizeof(struct lin_frame));
+}
+
 PERIPH_FUNC_DEF(lin_set_mode_j) {
     PERIPH_FUNC_GET_ARGS(lin, set_mode_j);
     PERIPH_FUNC_CHECK_ARGS_LEN(lin, set_mode_j);
@@ -328,6 +335,9 @@ static const periph_func_t lin_periph_fns[] = {
     lin_read,
 };
 
+static periph_stats_t lin_stats[DT_PROP_LEN(JABI_PERIPH_NODE, lin)];
+static periph_fn_stats_t lin_fn_stats[ARRAY_SIZE(lin_periph_fns)];
+
 const struct periph_api_t lin_periph_api = {
     .init = lin_init,
     .get_dev = lin_get_dev,
@@ -335,6 +345,9 @@ const struct periph_api_t lin_periph_api = {
     .num_fns = ARRAY_SIZE(lin_periph_fns),
     .num_idx = DT_PROP_LEN(JABI_PERIPH_NODE, lin),
     .name = "lin",
+    .rx_resize = lin_rx_resize,
+    .stats = lin_stats,
+    .fn_stats = lin_fn_stats,
 };
 
 #else // DT_NODE_HAS_PROP(JABI_PERIPH_NODE, lin)
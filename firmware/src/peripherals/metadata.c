@@ -1,3 +1,5 @@
+#include <zephyr/drivers/can.h>
+#include <zephyrboards/drivers/lin.h>
 #include <zephyr/sys/byteorder.h>
 #include <jabi.h>
 #include <jabi/peripherals/metadata.h>
@@ -5,7 +7,78 @@
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(periph_metadata, CONFIG_LOG_DEFAULT_LEVEL);
 
+#define LOCK_TIMEOUT K_MSEC(100)
+
+extern const struct periph_api_t *peripherals[];
+extern struct k_sem **peripheral_locks[];
+
+/* Shared receive arena, CAN/LIN/UART rx queues are slices of it laid out back
+ * to back. Boots w/ the *_BUFFER_SIZE partition, the host can then move memory
+ * between instances w/o a reflash. Resized or moved queues lose their contents.
+ */
+#define RX_ALIGN 4
+#define RX_NUM(prop) DT_PROP_LEN_OR(JABI_PERIPH_NODE, prop, 0)
+#define RX_NUM_BUFFERS (RX_NUM(can) + RX_NUM(lin) + RX_NUM(uart))
+#define RX_DEFAULT_SIZE                                                                      \
+    (RX_NUM(can)  * ROUND_UP(CONFIG_JABI_CAN_BUFFER_SIZE * CAN_RX_ITEM_SIZE, RX_ALIGN) +         \
+     RX_NUM(lin)  * ROUND_UP(CONFIG_JABI_LIN_BUFFER_SIZE * sizeof(struct lin_frame), RX_ALIGN) + \
+     RX_NUM(uart) * ROUND_UP(CONFIG_JABI_UART_RX_BUFFER_SIZE, RX_ALIGN))
+#define RX_ARENA_SIZE MAX(CONFIG_JABI_RX_ARENA_SIZE, RX_DEFAULT_SIZE)
+
+static const struct {
+    uint16_t periph_id;
+    uint16_t item_size; // largest item, CAN packs smaller frames
+    uint32_t default_size; // per instance
+} rx_periphs[] = {
+    { PERIPH_CAN_ID,  CAN_RX_ITEM_SIZE,         CONFIG_JABI_CAN_BUFFER_SIZE * CAN_RX_ITEM_SIZE },
+    { PERIPH_LIN_ID,  sizeof(struct lin_frame), CONFIG_JABI_LIN_BUFFER_SIZE * sizeof(struct lin_frame) },
+    { PERIPH_UART_ID, 1,                        CONFIG_JABI_UART_RX_BUFFER_SIZE },
+};
+
+typedef struct {
+    uint16_t periph_id;
+    uint16_t periph_idx;
+    uint16_t item_size;
+    uint32_t offset;
+    uint32_t size;
+} rx_buffer_t;
+
+static uint8_t __aligned(RX_ALIGN) rx_arena_mem[RX_ARENA_SIZE];
+static rx_buffer_t rx_buffers[RX_NUM_BUFFERS];
+
+static bool rx_buffer_changed(int i, uint32_t offset, uint32_t size) {
+    return rx_buffers[i].offset != offset || rx_buffers[i].size != size;
+}
+
+static void rx_arena_apply(const uint32_t *sizes) {
+    uint32_t offset = 0;
+    for (int i = 0; i < RX_NUM_BUFFERS; i++) {
+        rx_buffer_t *b = &rx_buffers[i];
+        if (rx_buffer_changed(i, offset, sizes[i])) {
+            unsigned int key = irq_lock(); // producers are ISRs
+            peripherals[b->periph_id]->rx_resize(b->periph_idx, &rx_arena_mem[offset], sizes[i]);
+            irq_unlock(key);
+            b->offset = offset;
+            b->size = sizes[i];
+        }
+        offset += ROUND_UP(sizes[i], RX_ALIGN);
+    }
+}
+
 static int metadata_init(uint16_t idx) {
+    // first peripheral initialized, queues are ready before their owners start
+    uint32_t sizes[RX_NUM_BUFFERS];
+    int n = 0;
+    for (int i = 0; i < ARRAY_SIZE(rx_periphs); i++) {
+        for (int j = 0; j < peripherals[rx_periphs[i].periph_id]->num_idx; j++) {
+            rx_buffers[n].periph_id = rx_periphs[i].periph_id;
+            rx_buffers[n].periph_idx = j;
+            rx_buffers[n].item_size = rx_periphs[i].item_size;
+            rx_buffers[n].offset = UINT32_MAX; // force initial resize
+            sizes[n++] = rx_periphs[i].default_size;
+        }
+    }
+    rx_arena_apply(sizes);
     return JABI_NO_ERR;
 }
 
@@ -92,6 +165,211 @@ int16_t jabi_metadata_custom(uint16_t idx, uint8_t *req, uint16_t req_len,
     return JABI_NOT_SUPPORTED_ERR;
 }
 
+PERIPH_FUNC_DEF(rx_arena) {
+    PERIPH_FUNC_GET_RET(metadata, rx_arena);
+    PERIPH_FUNC_CHECK_ARGS_EMPTY;
+
+    LOG_DBG("()");
+
+    if (sizeof(metadata_rx_arena_resp_t) + sizeof(metadata_rx_buffer_t) * RX_NUM_BUFFERS >
+            RESP_PAYLOAD_MAX_SIZE) {
+        LOG_ERR("too many rx buffers to report");
+        return JABI_NOT_SUPPORTED_ERR;
+    }
+
+    uint32_t used = 0;
+    for (int i = 0; i < RX_NUM_BUFFERS; i++) {
+        ret->buffers[i].periph_id = sys_cpu_to_le16(rx_buffers[i].periph_id);
+        ret->buffers[i].periph_idx = sys_cpu_to_le16(rx_buffers[i].periph_idx);
+        ret->buffers[i].size = sys_cpu_to_le32(rx_buffers[i].size);
+        used += ROUND_UP(rx_buffers[i].size, RX_ALIGN);
+    }
+    ret->size = sys_cpu_to_le32(RX_ARENA_SIZE);
+    ret->free = sys_cpu_to_le32(RX_ARENA_SIZE - used);
+    *resp_len = sizeof(metadata_rx_arena_resp_t) + sizeof(metadata_rx_buffer_t) * RX_NUM_BUFFERS;
+    return JABI_NO_ERR;
+}
+
+PERIPH_FUNC_DEF(set_rx_arena) {
+    PERIPH_FUNC_GET_ARGS(metadata, set_rx_arena);
+
+    if (req_len % sizeof(metadata_set_rx_arena_req_t)) {
+        return JABI_INVALID_ARGS_FORMAT_ERR;
+    }
+    int num = req_len / sizeof(metadata_set_rx_arena_req_t);
+
+    LOG_DBG("(num=%d)", num);
+
+    // unlisted buffers keep their size
+    uint32_t sizes[RX_NUM_BUFFERS];
+    for (int i = 0; i < RX_NUM_BUFFERS; i++) {
+        sizes[i] = rx_buffers[i].size;
+    }
+    for (int n = 0; n < num; n++) {
+        uint16_t periph_id = sys_le16_to_cpu(args[n].periph_id);
+        uint16_t periph_idx = sys_le16_to_cpu(args[n].periph_idx);
+        uint32_t size = sys_le32_to_cpu(args[n].size);
+        int i = 0;
+        while (i < RX_NUM_BUFFERS && (rx_buffers[i].periph_id != periph_id ||
+                                      rx_buffers[i].periph_idx != periph_idx)) {
+            i++;
+        }
+        if (i == RX_NUM_BUFFERS) {
+            LOG_ERR("no rx buffer for %d %d", periph_id, periph_idx);
+            return JABI_NOT_SUPPORTED_ERR;
+        }
+        if (size > RX_ARENA_SIZE) { // before rounding, sizes near UINT32_MAX wrap
+            LOG_ERR("rx buffer for %d %d larger than the arena", periph_id, periph_idx);
+            return JABI_INVALID_ARGS_ERR;
+        }
+        sizes[i] = size - size % rx_buffers[i].item_size;
+        if (sizes[i] == 0) {
+            LOG_ERR("rx buffer for %d %d must fit one item", periph_id, periph_idx);
+            return JABI_INVALID_ARGS_ERR;
+        }
+    }
+
+    uint64_t total = 0; // each term is at most the arena size, can't wrap
+    for (int i = 0; i < RX_NUM_BUFFERS; i++) {
+        total += ROUND_UP(sizes[i], RX_ALIGN);
+    }
+    if (total > RX_ARENA_SIZE) {
+        LOG_ERR("partition needs %llu bytes, arena only has %d",
+            (unsigned long long) total, RX_ARENA_SIZE);
+        return JABI_INVALID_ARGS_ERR;
+    }
+
+    // only lock the owners of queues that get reset, they may be mid read
+    struct k_sem *locks[RX_NUM_BUFFERS];
+    int num_locks = 0;
+    int16_t retcode = JABI_NO_ERR;
+    uint32_t offset = 0;
+    for (int i = 0; i < RX_NUM_BUFFERS && !retcode; i++) {
+        struct k_sem *lock = peripheral_locks[rx_buffers[i].periph_id][rx_buffers[i].periph_idx];
+        bool held = false;
+        for (int j = 0; j < num_locks; j++) {
+            held |= locks[j] == lock;
+        }
+        if (rx_buffer_changed(i, offset, sizes[i]) && !held) {
+            if (k_sem_take(lock, LOCK_TIMEOUT)) {
+                LOG_ERR("failed to acquire lock for %d %d",
+                    rx_buffers[i].periph_id, rx_buffers[i].periph_idx);
+                retcode = JABI_BUSY_ERR;
+            } else {
+                locks[num_locks++] = lock;
+            }
+        }
+        offset += ROUND_UP(sizes[i], RX_ALIGN);
+    }
+    if (!retcode) {
+        rx_arena_apply(sizes);
+    }
+    for (int j = 0; j < num_locks; j++) {
+        k_sem_give(locks[j]);
+    }
+
+    *resp_len = 0;
+    return retcode;
+}
+
+PERIPH_FUNC_DEF(periph_stats_j) {
+    PERIPH_FUNC_GET_ARGS(metadata, periph_stats);
+    PERIPH_FUNC_GET_RET(metadata, periph_stats);
+    PERIPH_FUNC_CHECK_ARGS_LEN(metadata, periph_stats);
+
+    args->periph_id = sys_le16_to_cpu(args->periph_id);
+    args->periph_idx = sys_le16_to_cpu(args->periph_idx);
+
+    LOG_DBG("(periph_id=0x%x,periph_idx=%d)", args->periph_id, args->periph_idx);
+
+    if (args->periph_id >= NUM_PERIPHERALS ||
+        args->periph_idx >= peripherals[args->periph_id]->num_idx) {
+        LOG_ERR("bad peripheral %d %d", args->periph_id, args->periph_idx);
+        return JABI_NOT_SUPPORTED_ERR;
+    }
+    const struct periph_api_t *api = peripherals[args->periph_id];
+    if (sizeof(metadata_periph_stats_resp_t) + sizeof(metadata_fn_stats_t) * api->num_fns >
+            RESP_PAYLOAD_MAX_SIZE) {
+        LOG_ERR("too many functions to report");
+        return JABI_NOT_SUPPORTED_ERR;
+    }
+
+    periph_stats_t *stats = periph_stats(args->periph_id, args->periph_idx);
+    ret->rx = sys_cpu_to_le32(atomic_get(&stats->rx));
+    ret->rx_dropped = sys_cpu_to_le32(atomic_get(&stats->rx_dropped));
+    ret->rx_high = sys_cpu_to_le32(atomic_get(&stats->rx_high));
+    ret->busy = sys_cpu_to_le32(atomic_get(&stats->busy));
+    ret->cycles_per_sec = sys_cpu_to_le32(sys_clock_hw_cycles_per_sec());
+    for (int i = 0; i < api->num_fns; i++) {
+        periph_fn_stats_t fn;
+        periph_fn_stats(args->periph_id, i, &fn);
+        ret->fns[i].calls = sys_cpu_to_le32(fn.calls);
+        ret->fns[i].cycles = sys_cpu_to_le64(fn.cycles);
+    }
+    *resp_len = sizeof(metadata_periph_stats_resp_t) + sizeof(metadata_fn_stats_t) * api->num_fns;
+    return JABI_NO_ERR;
+}
+
+PERIPH_FUNC_DEF(iface_stats_j) {
+    PERIPH_FUNC_GET_RET(metadata, iface_stats);
+    PERIPH_FUNC_CHECK_ARGS_EMPTY;
+
+    LOG_DBG("()");
+
+    if (sizeof(metadata_iface_stats_resp_t) * NUM_INTERFACES > RESP_PAYLOAD_MAX_SIZE) {
+        LOG_ERR("too many interfaces to report");
+        return JABI_NOT_SUPPORTED_ERR;
+    }
+    for (int i = 0; i < NUM_INTERFACES; i++) {
+        ret[i].rx_bytes = sys_cpu_to_le32(atomic_get(&iface_stats[i].rx_bytes));
+        ret[i].tx_bytes = sys_cpu_to_le32(atomic_get(&iface_stats[i].tx_bytes));
+        ret[i].errors = sys_cpu_to_le32(atomic_get(&iface_stats[i].errors));
+    }
+    *resp_len = sizeof(metadata_iface_stats_resp_t) * NUM_INTERFACES;
+    return JABI_NO_ERR;
+}
+
+PERIPH_FUNC_DEF(log_read) {
+    PERIPH_FUNC_CHECK_ARGS_EMPTY;
+
+    // no LOG_DBG, draining the log shouldn't refill it
+
+#ifdef CONFIG_JABI_LOG_BACKEND
+    PERIPH_FUNC_GET_RET(metadata, log_read);
+    *resp_len = jabi_log_read(ret, RESP_PAYLOAD_MAX_SIZE);
+    return JABI_NO_ERR;
+#else
+    LOG_ERR("log backend disabled");
+    return JABI_NOT_SUPPORTED_ERR;
+#endif // CONFIG_JABI_LOG_BACKEND
+}
+
+/* Link test endpoints, no peripheral work so what's measured is the interface */
+PERIPH_FUNC_DEF(sink) {
+    LOG_DBG("(len=%d)", req_len);
+
+    *resp_len = 0;
+    return JABI_NO_ERR;
+}
+
+static atomic_t source_seq;
+
+PERIPH_FUNC_DEF(source) {
+    PERIPH_FUNC_GET_RET(metadata, source);
+    PERIPH_FUNC_CHECK_ARGS_EMPTY;
+
+    LOG_DBG("()");
+
+    uint32_t seq = atomic_inc(&source_seq);
+    uint16_t len = RESP_PAYLOAD_MAX_SIZE - sizeof(metadata_source_resp_t);
+    for (uint16_t i = 0; i < len; i++) {
+        ret->data[i] = seq + i;
+    }
+    ret->seq = sys_cpu_to_le32(seq);
+    *resp_len = RESP_PAYLOAD_MAX_SIZE;
+    return JABI_NO_ERR;
+}
+
 static const periph_func_t metadata_periph_fns[] = {
     serial,
     num_inst,
@@ -99,8 +377,18 @@ static const periph_func_t metadata_periph_fns[] = {
     req_max_size,
     resp_max_size,
     jabi_metadata_custom,
+    rx_arena,
+    set_rx_arena,
+    periph_stats_j,
+    iface_stats_j,
+    log_read,
+    sink,
+    source,
 };
 
+static periph_stats_t metadata_stats[1];
+static periph_fn_stats_t metadata_fn_stats[ARRAY_SIZE(metadata_periph_fns)];
+
 const struct periph_api_t metadata_periph_api = {
     .init = metadata_init,
     .get_dev = metadata_get_dev,
@@ -108,4 +396,6 @@ const struct periph_api_t metadata_periph_api = {
     .num_fns = ARRAY_SIZE(metadata_periph_fns),
     .num_idx = 1,
     .name = "metadata",
+    .stats = metadata_stats,
+    .fn_stats = metadata_fn_stats,
 };
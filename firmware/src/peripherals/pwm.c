@@ -41,6 +41,9 @@ static const periph_func_t pwm_periph_fns[] = {
     pwm_write,
 };
 
+static periph_stats_t pwm_stats[DT_PROP_LEN(JABI_PERIPH_NODE, pwm)];
+static periph_fn_stats_t pwm_fn_stats[ARRAY_SIZE(pwm_periph_fns)];
+
 const struct periph_api_t pwm_periph_api = {
     .init = pwm_init,
     .get_dev = pwm_get_dev,
@@ -48,6 +51,8 @@ const struct periph_api_t pwm_periph_api = {
     .num_fns = ARRAY_SIZE(pwm_periph_fns),
     .num_idx = DT_PROP_LEN(JABI_PERIPH_NODE, pwm),
     .name = "pwm",
+    .stats = pwm_stats,
+    .fn_stats = pwm_fn_stats,
 };
 
 #else
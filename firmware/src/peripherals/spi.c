@@ -191,6 +191,9 @@ static const periph_func_t spi_periph_fns[] = {
     spi_transceive_j,
 };
 
+static periph_stats_t spi_stats[DT_PROP_LEN(JABI_PERIPH_NODE, spi)];
+static periph_fn_stats_t spi_fn_stats[ARRAY_SIZE(spi_periph_fns)];
+
 const struct periph_api_t spi_periph_api = {
     .init = spi_init,
     .get_dev = spi_get_dev,
@@ -198,6 +201,8 @@ const struct periph_api_t spi_periph_api = {
     .num_fns = ARRAY_SIZE(spi_periph_fns),
     .num_idx = DT_PROP_LEN(JABI_PERIPH_NODE, spi),
     .name = "spi",
+    .stats = spi_stats,
+    .fn_stats = spi_fn_stats,
 };
 
 #else
@@ -31,7 +31,7 @@ typedef struct {
     },
 
 #define GEN_UART_MSGQ(node_id, prop, idx) \
-    K_MSGQ_DEFINE(uart_msgq##idx, 1, CONFIG_JABI_UART_RX_BUFFER_SIZE, 1);
+    static struct k_msgq uart_msgq##idx; // buffer is a slice of the rx arena
 
 DT_FOREACH_PROP_ELEM(JABI_PERIPH_NODE, uart, GEN_UART_MSGQ);
 
@@ -64,13 +64,21 @@ static void uart_handler(const struct device *dev, void *data) {
                 LOG_ERR("failed to read uart?!");
                 continue;
             }
+            uint32_t dropped = 0;
+            uint32_t queued = 0;
             for (int i = 0; i < len; i++) {
                 if (k_msgq_put(dev_data->rx_msgq, &buffer[i], K_NO_WAIT)) {
                     LOG_ERR("buffer full, purging all of it");
+                    queued = k_msgq_num_used_get(dev_data->rx_msgq);
+                    dropped = queued + len - i;
                     k_msgq_purge(dev_data->rx_msgq);
                     break;
                 }
             }
+            if (!dropped) {
+                queued = k_msgq_num_used_get(dev_data->rx_msgq);
+            }
+            periph_stats_rx(periph_stats(PERIPH_UART_ID, dev_data - uart_devs), len, dropped, queued);
         }
     }
 }
@@ -86,6 +94,10 @@ static void *uart_get_dev(uint16_t idx) {
     return (void*) uart_devs[idx].dev;
 }
 
+static void uart_rx_resize(uint16_t idx, uint8_t *buf, uint32_t size) {
+    k_msgq_init(uart_devs[idx].rx_msgq, (char*) buf, 1, size);
+}
+
 PERIPH_FUNC_DEF(uart_set_config) {
     PERIPH_FUNC_GET_ARGS(uart, set_config);
     PERIPH_FUNC_CHECK_ARGS_LEN(uart, set_config);
@@ -189,6 +201,9 @@ static const periph_func_t uart_periph_fns[] = {
     uart_read,
 };
 
+static periph_stats_t uart_stats[DT_PROP_LEN(JABI_PERIPH_NODE, uart)];
+static periph_fn_stats_t uart_fn_stats[ARRAY_SIZE(uart_periph_fns)];
+
 const struct periph_api_t uart_periph_api = {
     .init = uart_init,
     .get_dev = uart_get_dev,
@@ -196,6 +211,9 @@ const struct periph_api_t uart_periph_api = {
     .num_fns = ARRAY_SIZE(uart_periph_fns),
     .num_idx = DT_PROP_LEN(JABI_PERIPH_NODE, uart),
     .name = "uart",
+    .rx_resize = uart_rx_resize,
+    .stats = uart_stats,
+    .fn_stats = uart_fn_stats,
 };
 
 #else
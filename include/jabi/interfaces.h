@@ -21,33 +21,49 @@
 #define RESP_PAYLOAD_MAX_SIZE 128 // safe minimum
 #endif
 
+/* Tagged requests set this bit in periph_fn and append a uint16_t tag to the
+ * payload. The response payload ends w/ the same tag, even on error, and may
+ * be sent before responses to earlier requests for other devices. Tags fit
+ * past the maximum payload sizes, so any request can be tagged.
+ */
+#define IFACE_FN_TAGGED 0x8000
+#define IFACE_TAG_SIZE  sizeof(uint16_t)
+
 PACKED(iface_req_t,
     uint16_t periph_id;
     uint16_t periph_idx;
     uint16_t periph_fn;
     uint16_t payload_len;
-    uint8_t payload[REQ_PAYLOAD_MAX_SIZE];
+    uint8_t payload[REQ_PAYLOAD_MAX_SIZE + IFACE_TAG_SIZE];
 );
 
 PACKED(iface_resp_t,
     int16_t retcode;
     uint16_t payload_len;
-    uint8_t payload[RESP_PAYLOAD_MAX_SIZE];
+    uint8_t payload[RESP_PAYLOAD_MAX_SIZE + IFACE_TAG_SIZE];
 );
 
-typedef int  (*iface_init_t)(void);
-typedef void (*iface_get_req_t)(iface_req_t *req);
-typedef void (*iface_send_resp_t)(iface_resp_t *resp);
+/* Buffers are owned by the interface, so requests can be processed and
+ * responses built in place. A request buffer is lent out by get_req until
+ * free_req, a response buffer by alloc_resp until send_resp.
+ */
+typedef int           (*iface_init_t)(void);
+typedef iface_req_t  *(*iface_get_req_t)(void);
+typedef void          (*iface_free_req_t)(iface_req_t *req);
+typedef iface_resp_t *(*iface_alloc_resp_t)(void);
+typedef void          (*iface_send_resp_t)(iface_resp_t *resp);
 
 struct iface_api_t {
     const iface_init_t init;
     const iface_get_req_t get_req;
+    const iface_free_req_t free_req;
+    const iface_alloc_resp_t alloc_resp;
     const iface_send_resp_t send_resp;
     const char *name;
 };
 
-#define IFACE_REQ_HDR_SIZE  (sizeof(iface_req_t) - REQ_PAYLOAD_MAX_SIZE)
-#define IFACE_RESP_HDR_SIZE (sizeof(iface_resp_t) - RESP_PAYLOAD_MAX_SIZE)
+#define IFACE_REQ_HDR_SIZE  (sizeof(iface_req_t) - REQ_PAYLOAD_MAX_SIZE - IFACE_TAG_SIZE)
+#define IFACE_RESP_HDR_SIZE (sizeof(iface_resp_t) - RESP_PAYLOAD_MAX_SIZE - IFACE_TAG_SIZE)
 
 extern void iface_req_to_le(iface_req_t *req);
 extern void iface_resp_to_le(iface_resp_t *resp);
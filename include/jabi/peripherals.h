@@ -7,6 +7,10 @@ typedef int     (*periph_init_t)(uint16_t idx);
 typedef void*   (*periph_get_dev_t)(uint16_t idx);
 typedef int16_t (*periph_func_t)(uint16_t idx, uint8_t *req, uint16_t req_len,
                                  uint8_t *resp, uint16_t *resp_len);
+typedef void    (*periph_rx_resize_t)(uint16_t idx, uint8_t *buf, uint32_t size);
+
+struct periph_stats;    // firmware only, counters reported through metadata
+struct periph_fn_stats;
 
 struct periph_api_t {
     const periph_init_t init;
@@ -15,6 +19,9 @@ struct periph_api_t {
     const uint16_t num_fns;
     const uint16_t num_idx;
     const char *name;
+    const periph_rx_resize_t rx_resize; // optional, rx queue lives in the rx arena
+    struct periph_stats *const stats;       // num_idx entries, static so the heap stays small
+    struct periph_fn_stats *const fn_stats; // num_fns entries
 };
 
 /* Peripheral indices */
@@ -10,6 +10,21 @@ PACKED(can_set_filter_req_t,
     uint32_t id_mask;
 );
 
+PACKED(can_filter_entry_t,
+    uint32_t id;
+    uint32_t id_mask;
+    uint8_t  id_type; /* 0=standard, 1=extended */
+);
+
+PACKED(can_set_filters_req_t, // replaces can_set_filter, 0 filters accepts nothing
+    uint8_t num_filters;
+    can_filter_entry_t filters[];
+);
+
+PACKED(can_set_filters_resp_t,
+    uint8_t num_hw; // w/ a controller filter of their own, rest share merged ones and are matched in software
+);
+
 PACKED(can_set_rate_req_t,
     uint32_t bitrate;
     uint32_t bitrate_data;
@@ -46,6 +61,167 @@ PACKED(can_read_resp_t, // empty response if none to read
     uint8_t  data[];
 );
 
+PACKED(can_read_many_req_t,
+    uint16_t max_msgs; // 0 for as many as fit
+);
+
+PACKED(can_read_many_msg_t,
+    uint32_t id;
+    uint8_t  id_type;  /* 0=standard, 1=extended */
+    uint8_t  fd;
+    uint8_t  brs;
+    uint8_t  rtr;      /* 0=data frame, 1=remote request */
+    uint8_t  data_len;
+    uint8_t  data[];   // omitted for remote requests
+);
+
+PACKED(can_read_many_resp_t,
+    uint16_t num_left;
+    uint16_t num_msgs;
+    uint8_t  msgs[];   // can_read_many_msg_t packed back to back, *_ts_msg_t for read_many_ts
+);
+
+PACKED(can_read_many_ts_msg_t, // can_read_many_msg_t w/ timestamps in front
+    uint64_t timestamp;    // us since device boot, taken at rx
+    uint16_t hw_timestamp; // controller counter if it has one, else 0
+    uint32_t id;
+    uint8_t  id_type;  /* 0=standard, 1=extended */
+    uint8_t  fd;
+    uint8_t  brs;
+    uint8_t  rtr;      /* 0=data frame, 1=remote request */
+    uint8_t  data_len;
+    uint8_t  data[];   // omitted for remote requests
+);
+
+typedef uint8_t can_write_many_req_t; // can_write_req_t packed back to back
+
+PACKED(can_write_many_resp_t, // returns once queued, not sent
+    uint16_t num_queued; // from the front, rest didn't fit
+    uint16_t num_free;
+);
+
+PACKED(can_tx_stats_resp_t, // counters since boot
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t failed;
+    uint16_t pending;
+);
+
+PACKED(can_bus_stats_req_t,
+    uint8_t reset_ids; // clear the frequent id counts after reading
+);
+
+PACKED(can_bus_stats_id_t,
+    uint32_t id;
+    uint8_t  id_type; /* 0=standard, 1=extended */
+    uint32_t count;   // upper bound once an id has been evicted
+);
+
+PACKED(can_bus_stats_resp_t, // rx counts frames the controller's filters let in
+    uint32_t rx_frames;     // since boot
+    uint32_t rx_bytes;
+    uint32_t tx_frames;
+    uint32_t tx_bytes;
+    uint32_t rx_frame_rate; // per second, over the last second
+    uint32_t rx_byte_rate;
+    uint32_t tx_frame_rate;
+    uint32_t tx_byte_rate;
+    uint16_t bus_load;      // 0.01% units, over the last second, w/o bit stuffing
+    uint32_t bit0_errors;   // error frames by type since boot, 0 w/o CONFIG_CAN_STATS
+    uint32_t bit1_errors;
+    uint32_t stuff_errors;
+    uint32_t crc_errors;
+    uint32_t form_errors;
+    uint32_t ack_errors;
+    uint32_t rx_overruns;
+    uint32_t error_warning; // times entered each state since boot
+    uint32_t error_passive;
+    uint32_t bus_off;
+    uint8_t  filtered;      // 1 if those drop some ids, rx counts are then a lower bound
+    uint8_t  num_ids;
+    can_bus_stats_id_t ids[]; // most frequent first
+);
+
+PACKED(can_isotp_bind_req_t, // also handles flow control for isotp_send, rx_id can't be covered by filters or routes
+    uint32_t tx_id;
+    uint32_t rx_id;
+    uint8_t  id_type;  /* 0=standard, 1=extended */
+    uint8_t  fd;
+    uint8_t  brs;
+    uint8_t  tx_dl;    // FD frame length, 0 for 8 or 64 if fd
+    uint8_t  ext_addr; // 1 for extended addressing w/ the bytes below
+    uint8_t  tx_ext_addr;
+    uint8_t  rx_ext_addr;
+    uint8_t  bs;       // block size and STmin sent in our flow control
+    uint8_t  stmin;
+);
+
+PACKED(can_isotp_send_req_t, // PDU is staged in order, sent once all of it is in
+    uint16_t total_len; // 0 waits on the transfer in flight
+    uint16_t offset;
+    uint8_t  data[];
+);
+
+PACKED(can_isotp_send_resp_t,
+    uint8_t done; // 0 if still sending, ask again w/ total_len=0
+);
+
+PACKED(can_isotp_recv_req_t,
+    uint16_t timeout_ms; // capped below the host timeout, ask again to wait longer
+);
+
+PACKED(can_isotp_recv_resp_t, // next chunk of one PDU, in order
+    uint16_t total_len; // 0 if nothing received
+    uint16_t offset;
+    uint8_t  data[];    // may be empty while waiting on the rest
+);
+
+PACKED(can_cyclic_set_req_t, // updating a running slot keeps its phase and counter
+    uint8_t  slot;
+    uint32_t period_us;     // 0 removes the slot
+    uint32_t offset_us;     // until the first send, new slots only
+    uint8_t  counter_byte;  // low counter_bits of this byte count up each send
+    uint8_t  counter_bits;  // 0 for no counter
+    uint8_t  checksum_byte; // over every other data byte, after the counter
+    uint8_t  checksum_type; /* 0=none, 1=xor, 2=sum, 3=crc8 SAE J1850 */
+    uint8_t  msg[];         // can_write_req_t
+);
+
+PACKED(can_cyclic_entry_t,
+    uint8_t  slot;
+    uint32_t period_us;
+    uint32_t sent;   // into the tx queue
+    uint32_t missed; // queue full or a whole period late
+);
+
+PACKED(can_cyclic_stats_resp_t, // active slots only
+    uint8_t num_entries;
+    can_cyclic_entry_t entries[];
+);
+
+PACKED(can_route_set_req_t, // frames from this instance forwarded to dst
+    uint8_t  route;
+    uint8_t  enable;       // 0 removes the route
+    uint32_t id;
+    uint32_t id_mask;
+    uint8_t  id_type;      /* 0=standard, 1=extended */
+    uint16_t dst;
+    uint32_t rewrite_mask; // id bits taken from new_id, 0 to keep the id
+    uint32_t new_id;
+);
+
+PACKED(can_route_entry_t,
+    uint8_t  route;
+    uint16_t dst;
+    uint32_t forwarded; // into dst's tx queue
+    uint32_t dropped;   // dst's tx queue full
+);
+
+PACKED(can_route_stats_resp_t, // active routes only
+    uint8_t num_entries;
+    can_route_entry_t entries[];
+);
+
 /* Function indices */
 #define CAN_SET_FILTER_ID  0
 #define CAN_SET_RATE_ID    1
@@ -53,5 +229,18 @@ PACKED(can_read_resp_t, // empty response if none to read
 #define CAN_STATE_ID       3
 #define CAN_WRITE_ID       4
 #define CAN_READ_ID        5
+#define CAN_READ_MANY_ID   6
+#define CAN_WRITE_MANY_ID  7
+#define CAN_TX_STATS_ID    8
+#define CAN_READ_MANY_TS_ID 9
+#define CAN_BUS_STATS_ID   10
+#define CAN_ISOTP_BIND_ID  11
+#define CAN_ISOTP_SEND_ID  12
+#define CAN_ISOTP_RECV_ID  13
+#define CAN_CYCLIC_SET_ID  14
+#define CAN_CYCLIC_STATS_ID 15
+#define CAN_ROUTE_SET_ID   16
+#define CAN_ROUTE_STATS_ID 17
+#define CAN_SET_FILTERS_ID 18
 
 #endif // JABI_PERIPHERALS_CAN_H
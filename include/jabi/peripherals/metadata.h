@@ -27,6 +27,56 @@ PACKED(metadata_resp_max_size_resp_t,
 typedef uint8_t metadata_custom_req_t;
 typedef uint8_t metadata_custom_resp_t;
 
+PACKED(metadata_rx_buffer_t,
+    uint16_t periph_id;
+    uint16_t periph_idx;
+    uint32_t size; // bytes
+);
+
+PACKED(metadata_rx_arena_resp_t,
+    uint32_t size; // bytes
+    uint32_t free;
+    metadata_rx_buffer_t buffers[];
+);
+
+typedef metadata_rx_buffer_t metadata_set_rx_arena_req_t;
+
+PACKED(metadata_periph_stats_req_t,
+    uint16_t periph_id;
+    uint16_t periph_idx;
+);
+
+PACKED(metadata_fn_stats_t,
+    uint32_t calls;
+    uint64_t cycles;
+);
+
+PACKED(metadata_periph_stats_resp_t,
+    uint32_t rx;         // frames received, bytes for uart
+    uint32_t rx_dropped;
+    uint32_t rx_high;    // queue high water mark, bytes
+    uint32_t busy;       // JABI_BUSY_ERR responses
+    uint32_t cycles_per_sec;
+    metadata_fn_stats_t fns[]; // shared by all instances
+);
+
+PACKED(metadata_iface_stats_t,
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+    uint32_t errors;
+);
+
+typedef metadata_iface_stats_t metadata_iface_stats_resp_t; // one per interface
+
+typedef uint8_t metadata_log_read_resp_t; // log text, lines may span reads
+
+typedef uint8_t metadata_sink_req_t; // anything, discarded
+
+PACKED(metadata_source_resp_t,
+    uint32_t seq;    // incremented every call
+    uint8_t data[];  // data[i] = seq + i, fills the response
+);
+
 /* Function indices */
 #define METADATA_SERIAL_ID        0
 #define METADATA_NUM_INST_ID      1
@@ -34,5 +84,12 @@ typedef uint8_t metadata_custom_resp_t;
 #define METADATA_REQ_MAX_SIZE_ID  3
 #define METADATA_RESP_MAX_SIZE_ID 4
 #define METADATA_CUSTOM_ID        5
+#define METADATA_RX_ARENA_ID      6
+#define METADATA_SET_RX_ARENA_ID  7
+#define METADATA_PERIPH_STATS_ID  8
+#define METADATA_IFACE_STATS_ID   9
+#define METADATA_LOG_READ_ID      10
+#define METADATA_SINK_ID          11
+#define METADATA_SOURCE_ID        12
 
 #endif // JABI_PERIPHERALS_METADATA_H